@@ -0,0 +1,168 @@
+#include <wx/wx.h>
+#include <wx/init.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+
+#include "listmodel.h"
+#include "exporter.h"
+#include "synthetic.h"
+
+using namespace std;
+
+
+// One timed operation
+struct BenchResult {
+
+    size_t  rows;
+    string  operation;
+    double  milliseconds;
+};
+
+
+class Bench {
+
+public:
+
+    vector<BenchResult> results;
+
+    // Time fn, print it and keep it for the JSON report
+    template<typename Fn>
+    void time(size_t rows, const string& operation, Fn fn) {
+
+        auto start = chrono::steady_clock::now();
+        fn();
+        auto end = chrono::steady_clock::now();
+
+        double ms = chrono::duration<double, milli>(end - start).count();
+        results.push_back({ rows, operation, ms });
+
+        printf("%12zu  %-20s %12.3f ms  %14.0f rows/s\n", rows, operation.c_str(), ms, ms > 0 ? rows / (ms / 1000.0) : 0.0);
+        fflush(stdout);
+    }
+
+    void run(size_t rows) {
+
+        // Generate outside the timed region so load only measures the model
+        SyntheticData data(42);
+        vector<ItemData> source;
+        source.reserve(rows);
+
+        for (size_t i = 0; i < rows; i++) {
+            source.push_back(data.next());
+        }
+
+        auto model = make_unique<ListModel>();
+
+        time(rows, "load", [&]() {
+            model->items = move(source);
+            model->rowsChanged();
+            });
+
+        time(rows, "sort_id", [&]() { model->sortByColumn(0); });
+        time(rows, "sort_name", [&]() { model->sortByColumn(1); });
+        time(rows, "sort_description", [&]() { model->sortByColumn(2); });
+
+        time(rows, "filter", [&]() { model->applyFilter("mocha"); });
+        time(rows, "filter_clear", [&]() { model->applyFilter(""); });
+
+        // What the list does for every visible cell (OnGetItemText)
+        size_t characters = 0;
+
+        time(rows, "cell_text", [&]() {
+            for (size_t i = 0; i < model->rowCount(); i++) {
+                for (long column = 0; column < ListModel::ColumnCount; column++) {
+                    characters += ListModel::cellText(model->itemAt(static_cast<long>(i)), column).length();
+                }
+            }
+            });
+
+        // Export formatting without the disk
+        string buffer;
+
+        time(rows, "format_csv", [&]() {
+            for (size_t i = 0; i < model->rowCount(); i++) {
+
+                RowFormat::csv(buffer, model->itemAt(static_cast<long>(i)));
+
+                if (buffer.size() > ListExporter::BufferSize) {
+                    characters += buffer.size();
+                    buffer.clear();
+                }
+            }
+            });
+
+        time(rows, "teardown", [&]() { model.reset(); });
+
+        // keep the compiler from dropping the loops above
+        if (characters == 1) {
+            printf("\n");
+        }
+    }
+
+    bool writeJson(const string& path) const {
+
+        FILE* file = fopen(path.c_str(), "w");
+
+        if (!file) {
+            return false;
+        }
+
+        fprintf(file, "{\n  \"benchmark\": \"wx3-list-bench\",\n  \"results\": [\n");
+
+        for (size_t i = 0; i < results.size(); i++) {
+
+            auto& r = results[i];
+            fprintf(file, "    { \"rows\": %zu, \"operation\": \"%s\", \"ms\": %.3f }%s\n",
+                r.rows, r.operation.c_str(), r.milliseconds, (i + 1 < results.size()) ? "," : "");
+        }
+
+        fprintf(file, "  ]\n}\n");
+
+        return fclose(file) == 0;
+    }
+};
+
+
+// Usage: wx3-list-bench [--max rows] [--json file]
+// Row counts run 1K, 10K, ... up to --max (default 1M, 100M needs ~10GB RAM)
+int main(int argc, char** argv) {
+
+    wxInitializer initializer;
+
+    if (!initializer.IsOk()) {
+        fprintf(stderr, "Failed to initialise wxWidgets\n");
+        return 1;
+    }
+
+    size_t maxRows = 1000000;
+    string jsonPath = "bench_results.json";
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+
+        if (strcmp(argv[i], "--max") == 0) {
+            maxRows = strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--json") == 0) {
+            jsonPath = argv[i + 1];
+        }
+    }
+
+    Bench bench;
+
+    for (size_t rows = 1000; rows <= maxRows && rows <= 100000000; rows *= 10) {
+        bench.run(rows);
+    }
+
+    if (!bench.writeJson(jsonPath)) {
+        fprintf(stderr, "Could not write %s\n", jsonPath.c_str());
+        return 1;
+    }
+
+    printf("Results written to %s\n", jsonPath.c_str());
+
+    return 0;
+}
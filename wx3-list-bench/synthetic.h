@@ -0,0 +1,51 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <random>
+#include <cstdint>
+
+#include "listmodel.h"
+
+
+// Synthetic rows - deterministic so runs on different commits see the same data
+class SyntheticData {
+
+public:
+
+    explicit SyntheticData(uint64_t seed) : rng(seed) {}
+
+    ItemData next() {
+
+        static const char* words[] = {
+            "coffee", "espresso", "latte", "mocha", "filter", "bean", "roast", "grind",
+            "arabica", "robusta", "crema", "brew", "decaf", "blend", "origin", "power"
+        };
+
+        ItemData item;
+        item.id = static_cast<int>(rng() % 100000000);
+
+        // names look like the example data ("C-big", "A-Some Item")
+        item.name = wxString::Format("%c-%s %u", static_cast<char>('A' + rng() % 26), words[rng() % 16], static_cast<unsigned>(rng() % 100000));
+
+        // descriptions are 2-8 words
+        int count = 2 + rng() % 7;
+        wxString description;
+
+        for (int i = 0; i < count; i++) {
+
+            if (i > 0) {
+                description += " ";
+            }
+
+            description += words[rng() % 16];
+        }
+
+        item.description = description;
+
+        return item;
+    }
+
+private:
+
+    std::mt19937_64 rng;
+};
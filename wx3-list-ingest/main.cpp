@@ -0,0 +1,103 @@
+#include <wx/wx.h>
+#include <wx/init.h>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+
+#include "sharedring.h"
+#include "synthetic.h"
+
+using namespace std;
+
+
+// Stand-in for an ingest process - writes synthetic rows into the shared
+// memory ring of a running wx3-virtual-lists (File > Receive Rows From
+// Ingest Process...), waiting whenever the list falls behind.
+//
+// Usage: wx3-list-ingest [--ring name] [--rows count] [--rate rows/s] [--seed n]
+// --rate 0 (the default) writes as fast as the ring allows
+int main(int argc, char** argv) {
+
+    wxInitializer initializer;
+
+    if (!initializer.IsOk()) {
+        fprintf(stderr, "Failed to initialise wxWidgets\n");
+        return 1;
+    }
+
+    string ringName = "rows";
+    size_t rowCount = 1000000;
+    double rate = 0;
+    uint64_t seed = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+
+        if (strcmp(argv[i], "--ring") == 0) {
+            ringName = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--rows") == 0) {
+            rowCount = strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--rate") == 0) {
+            rate = strtod(argv[i + 1], nullptr);
+        }
+        else if (strcmp(argv[i], "--seed") == 0) {
+            seed = strtoull(argv[i + 1], nullptr, 10);
+        }
+    }
+
+    string error;
+    unique_ptr<SharedRing> ring = SharedRing::open(ringName, error);
+
+    if (!ring) {
+        fprintf(stderr, "%s (is the list receiving rows on '%s'?)\n", error.c_str(), ringName.c_str());
+        return 1;
+    }
+
+    SharedRingWriter writer(*ring);
+    SyntheticData data(seed);
+
+    auto start = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < rowCount; i++) {
+
+        // pace to --rate
+        if (rate > 0) {
+
+            auto due = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(i / rate));
+
+            if (due > chrono::steady_clock::now()) {
+                writer.publish();
+                this_thread::sleep_until(due);
+            }
+        }
+
+        ItemData item = data.next();
+
+        SharedRowRecord* record = writer.claim();
+
+        if (!record) {
+            fprintf(stderr, "The list stopped taking rows after %zu\n", i);
+            return 1;
+        }
+
+        wxScopedCharBuffer name = item.name.utf8_str();
+        wxScopedCharBuffer description = item.description.utf8_str();
+
+        record->id = item.id;
+        SharedRingWriter::setText(record->name, record->nameLength, SharedRowRecord::NameBytes, name.data(), name.length());
+        SharedRingWriter::setText(record->description, record->descriptionLength, SharedRowRecord::DescriptionBytes, description.data(), description.length());
+
+        writer.commit();
+    }
+
+    writer.close();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("%zu rows written to '%s' in %.2fs (%.0f rows/s)\n", rowCount, ringName.c_str(), seconds, seconds > 0 ? rowCount / seconds : 0.0);
+
+    return 0;
+}
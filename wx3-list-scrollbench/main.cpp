@@ -0,0 +1,349 @@
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "listmodel.h"
+#include "virtuallist.h"
+#include "synthetic.h"
+#include "computedcolumn.h"
+
+using namespace std;
+
+
+// Count every heap allocation so we can report allocations per frame
+static atomic<size_t> allocationCount{ 0 };
+
+void* operator new(size_t size) {
+
+    allocationCount.fetch_add(1, memory_order_relaxed);
+
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) {
+
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+
+// Measurements for one scripted scroll sequence
+struct SequenceResult {
+
+    string          name;
+    vector<double>  frameMs;
+    vector<size_t>  frameAllocations;
+    vector<size_t>  frameTextRequests;
+
+    static double percentile(vector<double> values, double p) {
+
+        if (values.empty()) {
+            return 0.0;
+        }
+
+        sort(values.begin(), values.end());
+        size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+
+        return values[index];
+    }
+
+    static double mean(const vector<size_t>& values) {
+
+        double total = 0;
+
+        for (size_t v : values) {
+            total += v;
+        }
+
+        return values.empty() ? 0.0 : total / values.size();
+    }
+};
+
+
+class ScrollBenchFrame : public wxFrame {
+
+private:
+
+    ListModel* model;
+
+    VirtualList* listView{ nullptr };
+
+public:
+
+    ScrollBenchFrame(ListModel* model) : wxFrame(nullptr, wxID_ANY, "VirtualList scroll benchmark", wxDefaultPosition, wxSize(1024, 768)) {
+
+        this->model = model;
+
+        wxPanel* panel = new wxPanel(this);
+        wxBoxSizer* sizer = new wxBoxSizer(wxVERTICAL);
+
+        panel->SetSizer(sizer);
+
+        listView = new VirtualList(panel, wxID_ANY, wxDefaultPosition, wxDefaultSize, this->model);
+        sizer->Add(listView, 1, wxALL | wxEXPAND, 0);
+
+        listView->RefreshAfterUpdate();
+    }
+
+    // Widen the table with columns id * 1 ... id * count
+    void addColumns(int count) {
+
+        vector<shared_ptr<ComputedColumn>> columns;
+        wxString error;
+
+        for (int k = 1; k <= count; k++) {
+            columns.push_back(ComputedColumn::compile(wxString::Format("id * %d", k), error));
+        }
+
+        listView->addComputedColumns(columns);
+        listView->Update();
+    }
+
+    // Run one frame: apply the scroll, then force the paint to complete
+    void frame(SequenceResult& result, int dy, int dx = 0) {
+
+        size_t allocationsBefore = allocationCount.load();
+        size_t textBefore = listView->textRequests;
+
+        auto start = chrono::steady_clock::now();
+
+        listView->ScrollList(dx, dy);
+        listView->Update();
+
+        auto end = chrono::steady_clock::now();
+
+        result.frameMs.push_back(chrono::duration<double, milli>(end - start).count());
+        result.frameAllocations.push_back(allocationCount.load() - allocationsBefore);
+        result.frameTextRequests.push_back(listView->textRequests - textBefore);
+    }
+
+    int rowHeight() const {
+
+        wxRect rect;
+
+        if (listView->GetItemCount() > 0 && listView->GetItemRect(listView->GetTopItem(), rect)) {
+            return max(rect.GetHeight(), 1);
+        }
+
+        return 20;
+    }
+
+    void scrollToTop() {
+
+        listView->EnsureVisible(0);
+        listView->Update();
+    }
+
+    // Page down from the top, wrapping back to the top at the end
+    SequenceResult pageDown(int frames) {
+
+        SequenceResult result{ "page_down" };
+        scrollToTop();
+
+        int page = max(listView->GetCountPerPage(), 1);
+        int dy = page * rowHeight();
+
+        for (int i = 0; i < frames; i++) {
+
+            if (listView->GetTopItem() + 2 * page >= listView->GetItemCount()) {
+                scrollToTop();
+            }
+
+            frame(result, dy);
+        }
+
+        return result;
+    }
+
+    // Drag the scroll thumb from top to bottom - jumps of varying size,
+    // so every frame lands on rows that have never been painted
+    SequenceResult dragScroll(int frames) {
+
+        SequenceResult result{ "drag_scroll" };
+        scrollToTop();
+
+        long rows = listView->GetItemCount();
+        int height = rowHeight();
+
+        for (int i = 1; i <= frames; i++) {
+
+            long target = rows * i / frames;
+            long top = listView->GetTopItem();
+
+            frame(result, static_cast<int>((target - top) * height));
+        }
+
+        return result;
+    }
+
+    // Scroll sideways across a wide table a page width at a time,
+    // wrapping back to the first column at the right edge
+    SequenceResult sideScroll(int frames) {
+
+        SequenceResult result{ "side_scroll" };
+        scrollToTop();
+
+        int page = max(listView->GetClientSize().x, 1);
+
+        for (int i = 0; i < frames; i++) {
+
+            int before = listView->GetScrollPos(wxHORIZONTAL);
+            frame(result, 0, page);
+
+            if (listView->GetScrollPos(wxHORIZONTAL) == before) {
+                listView->ScrollList(-before, 0);
+                listView->Update();
+            }
+        }
+
+        return result;
+    }
+};
+
+
+class MyApp : public wxApp {
+
+private:
+
+    ListModel* model{ nullptr };
+    ScrollBenchFrame* frame{ nullptr };
+
+    size_t rows = 1000000;
+    int frames = 200;
+    int columns = 0;
+    string jsonPath = "scroll_results.json";
+
+public:
+
+    bool OnInit() override;
+
+    void runBenchmark();
+
+    bool writeJson(const vector<SequenceResult>& results) const;
+};
+
+
+// Usage: wx3-list-scrollbench [--rows n] [--frames n] [--columns n] [--json file]
+bool MyApp::OnInit()
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+
+        wxString option = argv[i];
+        wxString value = argv[i + 1];
+        long number = 0;
+
+        if (option == "--rows" && value.ToLong(&number)) {
+            rows = static_cast<size_t>(number);
+        }
+        else if (option == "--frames" && value.ToLong(&number)) {
+            frames = static_cast<int>(number);
+        }
+        else if (option == "--columns" && value.ToLong(&number)) {
+            columns = static_cast<int>(number);
+        }
+        else if (option == "--json") {
+            jsonPath = value.ToStdString();
+        }
+    }
+
+    model = new ListModel();
+
+    SyntheticData data(42);
+    model->items.reserve(rows);
+
+    for (size_t i = 0; i < rows; i++) {
+        model->items.push_back(data.next());
+    }
+
+    model->rowsChanged();
+
+    frame = new ScrollBenchFrame(model);
+    frame->Show();
+
+    if (columns > 0) {
+        frame->addColumns(columns);
+    }
+
+    // Start once the frame has been laid out and painted for the first time
+    CallAfter([this]() { this->runBenchmark(); });
+
+    return true;
+}
+
+void MyApp::runBenchmark()
+{
+    vector<SequenceResult> results;
+
+    // Warm up caches/fonts before measuring
+    frame->pageDown(10);
+
+    results.push_back(frame->pageDown(frames));
+    results.push_back(frame->dragScroll(frames));
+
+    if (columns > 0) {
+        results.push_back(frame->sideScroll(frames));
+    }
+
+    for (auto& r : results) {
+
+        printf("%-12s frames %4zu  p50 %8.3f ms  p99 %8.3f ms  allocs/frame %8.1f  OnGetItemText/frame %8.1f\n",
+            r.name.c_str(), r.frameMs.size(),
+            SequenceResult::percentile(r.frameMs, 0.50), SequenceResult::percentile(r.frameMs, 0.99),
+            SequenceResult::mean(r.frameAllocations), SequenceResult::mean(r.frameTextRequests));
+    }
+
+    if (!writeJson(results)) {
+        fprintf(stderr, "Could not write %s\n", jsonPath.c_str());
+    }
+
+    fflush(stdout);
+
+    frame->Destroy();
+    ExitMainLoop();
+}
+
+bool MyApp::writeJson(const vector<SequenceResult>& results) const
+{
+    FILE* file = fopen(jsonPath.c_str(), "w");
+
+    if (!file) {
+        return false;
+    }
+
+    fprintf(file, "{\n  \"benchmark\": \"wx3-list-scrollbench\",\n  \"rows\": %zu,\n  \"sequences\": [\n", rows);
+
+    for (size_t i = 0; i < results.size(); i++) {
+
+        auto& r = results[i];
+        size_t maxAllocations = r.frameAllocations.empty() ? 0 : *max_element(r.frameAllocations.begin(), r.frameAllocations.end());
+
+        fprintf(file, "    { \"name\": \"%s\", \"frames\": %zu, \"p50_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f, "
+            "\"allocs_per_frame_mean\": %.1f, \"allocs_per_frame_max\": %zu, \"text_requests_per_frame_mean\": %.1f }%s\n",
+            r.name.c_str(), r.frameMs.size(),
+            SequenceResult::percentile(r.frameMs, 0.50), SequenceResult::percentile(r.frameMs, 0.99), SequenceResult::percentile(r.frameMs, 1.0),
+            SequenceResult::mean(r.frameAllocations), maxAllocations, SequenceResult::mean(r.frameTextRequests),
+            (i + 1 < results.size()) ? "," : "");
+    }
+
+    fprintf(file, "  ]\n}\n");
+
+    return fclose(file) == 0;
+}
+
+// Tell wxWidgets app class to use
+IMPLEMENT_APP(MyApp);
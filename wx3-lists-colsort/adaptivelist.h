@@ -0,0 +1,447 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+#include <vector>
+#include <span>
+#include <unordered_set>
+#include <algorithm>
+
+
+// Virtual report list over a vector of row pointers - text is formatted
+// on demand, so the control keeps no copy of it
+template <typename Row>
+class RowListView : public wxListView {
+
+public:
+
+    using CellText = wxString(*)(const Row& row, long column);
+
+    RowListView(wxWindow* parent, const std::vector<Row*>& rows, CellText cellText)
+        : wxListView(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_VIRTUAL), rows(rows), cellText(cellText) {
+    }
+
+    wxString OnGetItemText(long item, long column) const override {
+
+        return cellText(*rows[item], column);
+    }
+
+private:
+
+    const std::vector<Row*>& rows;
+    CellText cellText;
+};
+
+
+// Report list of Row pointers that is an ordinary wxListView while small
+// and becomes virtual (RowListView) once it holds more than the threshold
+// rows.  A normal list stores a copy of every cell's text on top of the
+// rows themselves; past the threshold that copy is dropped and insertion
+// stops creating control items.  Rows, order and selection carry over
+// when it switches, and it goes back to a normal list when cleared.
+//
+// It remembers the column, comparator and direction it is sorted on, so
+// sorting the same column the other way just reverses the rows (O(n), no
+// comparisons) and rows added later go straight to their sorted position
+// (a binary search - O(log n) comparisons each, no re-sort).
+//
+// Column clicks etc. are list events, which propagate - bind them on this
+// panel rather than on control() (which is replaced on a switch).
+template <typename Row>
+class AdaptiveListView : public wxPanel {
+
+public:
+
+    using CellText = wxString(*)(const Row& row, long column);
+
+    // Fills anything a comparator needs precomputed in a row (a sort key)
+    using Prepare = void(*)(Row& row);
+
+    static constexpr size_t DefaultThreshold = 20000;
+
+    AdaptiveListView(wxWindow* parent, CellText cellText, size_t virtualThreshold = DefaultThreshold)
+        : wxPanel(parent), cellText(cellText), threshold(virtualThreshold) {
+
+        SetSizer(new wxBoxSizer(wxVERTICAL));
+        recreate(false);
+    }
+
+    wxListView* control() const { return list; }
+
+    bool isVirtual() const { return virtualMode; }
+
+    // Takes effect on the next insert
+    void setVirtualThreshold(size_t rows) { threshold = rows; }
+
+    void appendColumn(const wxString& title, int width) {
+
+        columns.push_back({ title, width });
+        list->AppendColumn(title, wxLIST_FORMAT_LEFT, width);
+    }
+
+    long rowCount() const { return list->GetItemCount(); }
+
+    // Row shown at a list index
+    Row* rowAt(long index) const {
+
+        return virtualMode ? rows[index] : reinterpret_cast<Row*>(list->GetItemData(index));
+    }
+
+    void add(Row* row) {
+
+        add(std::span<Row* const>(&row, 1));
+    }
+
+    // Add rows - at the end, or at their sorted positions while the list
+    // is sorted.  Many at once go in one frozen batch.
+    void add(std::span<Row* const> added) {
+
+        if (!virtualMode && static_cast<size_t>(rowCount()) + added.size() > threshold) {
+            switchToVirtual();
+        }
+
+        if (sortedColumn >= 0 && sortPrepare) {
+            for (Row* row : added) {
+                sortPrepare(*row);
+            }
+        }
+
+        if (virtualMode) {
+            addVirtual(added);
+            return;
+        }
+
+        bool batch = added.size() > 1;
+
+        if (batch) {
+            list->Freeze();
+        }
+
+        for (Row* row : added) {
+            insertItem(sortedColumn >= 0 ? sortedPosition(row) : rowCount(), row);
+        }
+
+        if (batch) {
+            list->Thaw();
+        }
+    }
+
+    // Rows are in order of this column (see sort)
+    bool isSortedOn(int column) const { return column >= 0 && column == sortedColumn; }
+
+    // Sort on a column with a SortItems style callback (client data is the
+    // Row*) - direction 1 ascending, -1 descending.  prepare (if any) is
+    // run on every row first, and on rows added while sorted.
+    void sort(int column, wxListCtrlCompare compare, int direction, Prepare prepare = nullptr) {
+
+        if (isSortedOn(column)) {
+
+            if (direction == -sortedDirection) {
+                reverse();
+            }
+
+            sortedDirection = direction;
+            return;
+        }
+
+        sortedColumn = column;
+        sortedDirection = direction;
+        sortCompare = compare;
+        sortPrepare = prepare;
+
+        if (prepare) {
+
+            long count = rowCount();
+
+            for (long index = 0; index < count; index++) {
+                prepare(*rowAt(index));
+            }
+        }
+
+        if (!virtualMode) {
+            list->SortItems(compare, direction);
+            return;
+        }
+
+        // a virtual list's selection is by index - keep it with the rows
+        std::vector<Row*> selected = selectedRows();
+
+        std::stable_sort(rows.begin(), rows.end(), [compare, direction](Row* a, Row* b) {
+            return compare(reinterpret_cast<wxIntPtr>(a), reinterpret_cast<wxIntPtr>(b), direction) < 0;
+            });
+
+        select(selected);
+        list->Refresh();
+    }
+
+    // Remove every row (the rows themselves belong to the caller)
+    void clear() {
+
+        sortedColumn = -1;
+
+        if (virtualMode) {
+
+            recreate(false);
+            rows.clear();
+            rows.shrink_to_fit();
+        }
+        else {
+            list->DeleteAllItems();
+        }
+    }
+
+    std::vector<Row*> selectedRows() const {
+
+        std::vector<Row*> selected;
+
+        for (long index = list->GetFirstSelected(); index != -1; index = list->GetNextSelected(index)) {
+            selected.push_back(rowAt(index));
+        }
+
+        return selected;
+    }
+
+    // Select exactly these rows
+    void select(const std::vector<Row*>& selected) {
+
+        for (long index = list->GetFirstSelected(); index != -1; index = list->GetNextSelected(index)) {
+            list->Select(index, false);
+        }
+
+        if (selected.empty()) {
+            return;
+        }
+
+        std::unordered_set<Row*> wanted(selected.begin(), selected.end());
+        long count = rowCount();
+
+        for (long index = 0; index < count; index++) {
+
+            if (wanted.count(rowAt(index))) {
+                list->Select(index);
+            }
+        }
+    }
+
+private:
+
+    struct Column {
+
+        wxString    title;
+        int         width;
+    };
+
+    wxListView* list{ nullptr };
+    CellText cellText;
+    size_t threshold;
+    bool virtualMode{ false };
+
+    std::vector<Column> columns;
+    std::vector<Row*> rows;     // virtual mode only, in display order
+
+    int sortedColumn{ -1 };
+    int sortedDirection{ 1 };
+    wxListCtrlCompare sortCompare{ nullptr };
+    Prepare sortPrepare{ nullptr };
+
+    // Before the sorted order puts row before the other
+    bool sortsBefore(Row* row, Row* other) const {
+
+        return sortCompare(reinterpret_cast<wxIntPtr>(row), reinterpret_cast<wxIntPtr>(other), sortedDirection) < 0;
+    }
+
+    // Index a row goes at in the sorted list - after any equal rows
+    long sortedPosition(Row* row) const {
+
+        long low = 0;
+        long high = rowCount();
+
+        while (low < high) {
+
+            long middle = low + (high - low) / 2;
+
+            if (sortsBefore(row, rowAt(middle))) {
+                high = middle;
+            }
+            else {
+                low = middle + 1;
+            }
+        }
+
+        return low;
+    }
+
+    void addVirtual(std::span<Row* const> added) {
+
+        // selected rows after a single new one move down by one
+        std::vector<long> moved;
+
+        if (sortedColumn < 0) {
+            rows.insert(rows.end(), added.begin(), added.end());
+        }
+        else if (added.size() == 1) {
+
+            long at = sortedPosition(added[0]);
+
+            for (long index = list->GetFirstSelected(); index != -1; index = list->GetNextSelected(index)) {
+                if (index >= at) {
+                    moved.push_back(index);
+                }
+            }
+
+            rows.insert(rows.begin() + at, added[0]);
+        }
+        else {
+
+            // sort the new rows on their own and merge them in
+            std::vector<Row*> selected = selectedRows();
+            size_t old = rows.size();
+
+            rows.insert(rows.end(), added.begin(), added.end());
+
+            auto before = [this](Row* a, Row* b) { return sortsBefore(a, b); };
+
+            std::stable_sort(rows.begin() + old, rows.end(), before);
+            std::inplace_merge(rows.begin(), rows.begin() + old, rows.end(), before);
+
+            select(selected);
+        }
+
+        list->SetItemCount(static_cast<long>(rows.size()));
+
+        for (auto index = moved.rbegin(); index != moved.rend(); ++index) {
+            list->Select(*index, false);
+            list->Select(*index + 1);
+        }
+
+        list->Refresh();
+    }
+
+    // Normal list item - text for every column, the Row* as client data
+    void insertItem(long index, Row* row) {
+
+        wxListItem item;
+        item.SetId(index);
+        item.SetText(cellText(*row, 0));
+        item.SetData(row);
+
+        list->InsertItem(item);
+
+        for (long column = 1; column < static_cast<long>(columns.size()); column++) {
+            list->SetItem(index, column, cellText(*row, column));
+        }
+    }
+
+    // Show the rows in the opposite order, selection staying with its rows
+    void reverse() {
+
+        long count = rowCount();
+
+        if (virtualMode) {
+
+            std::vector<long> selected;
+
+            for (long index = list->GetFirstSelected(); index != -1; index = list->GetNextSelected(index)) {
+                selected.push_back(index);
+            }
+
+            for (long index : selected) {
+                list->Select(index, false);
+            }
+
+            std::reverse(rows.begin(), rows.end());
+
+            for (long index : selected) {
+                list->Select(count - 1 - index);
+            }
+
+            list->Refresh();
+            return;
+        }
+
+        // a normal list can't move items - swap their contents end to end
+        list->Freeze();
+
+        for (long i = 0, j = count - 1; i < j; i++, j--) {
+
+            Row* first = rowAt(i);
+            Row* last = rowAt(j);
+
+            bool firstSelected = list->IsSelected(i);
+            bool lastSelected = list->IsSelected(j);
+
+            setItem(i, last);
+            setItem(j, first);
+
+            if (firstSelected != lastSelected) {
+                list->Select(i, lastSelected);
+                list->Select(j, firstSelected);
+            }
+        }
+
+        list->Thaw();
+    }
+
+    // Show a different row in an existing normal list item
+    void setItem(long index, Row* row) {
+
+        list->SetItemPtrData(index, reinterpret_cast<wxUIntPtr>(row));
+
+        for (long column = 0; column < static_cast<long>(columns.size()); column++) {
+            list->SetItem(index, column, cellText(*row, column));
+        }
+    }
+
+    void switchToVirtual() {
+
+        std::vector<Row*> selected = selectedRows();
+        long count = rowCount();
+
+        rows.clear();
+        rows.reserve(count);
+
+        for (long index = 0; index < count; index++) {
+            rows.push_back(rowAt(index));
+        }
+
+        recreate(true);
+        list->SetItemCount(count);
+
+        select(selected);
+    }
+
+    // Replace the control with a normal or virtual one with the same columns
+    void recreate(bool virtualStyle) {
+
+        wxListView* old = list;
+
+        if (virtualStyle) {
+            list = new RowListView<Row>(this, rows, cellText);
+        }
+        else {
+            list = new wxListView(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT);
+        }
+
+        virtualMode = virtualStyle;
+
+        // keep the user's column widths
+        for (size_t column = 0; column < columns.size(); column++) {
+
+            if (old) {
+                columns[column].width = old->GetColumnWidth(static_cast<int>(column));
+            }
+
+            list->AppendColumn(columns[column].title, wxLIST_FORMAT_LEFT, columns[column].width);
+        }
+
+        if (old) {
+            GetSizer()->Replace(old, list);
+            old->Destroy();
+        }
+        else {
+            GetSizer()->Add(list, 1, wxEXPAND, 0);
+        }
+
+        Layout();
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <type_traits>
+#include <cstdint>
+
+
+// Class and value type of a pointer to member
+template <typename T> struct MemberTraits;
+
+template <typename C, typename V>
+struct MemberTraits<V C::*> {
+
+    using Class = C;
+    using Value = V;
+};
+
+
+// Three way compare without copying - strings by reference, numbers directly
+inline int compareValues(const wxString& a, const wxString& b) { return a.compare(b); }
+
+template <typename V, typename = std::enable_if_t<std::is_arithmetic_v<V>>>
+inline int compareValues(V a, V b) { return (a > b) - (a < b); }
+
+
+// Order preserving integer key for a string: its first four characters,
+// 16 bits each.  Different keys order the strings the same way
+// wxString::compare does; equal keys mean "compare the strings".  A
+// character that doesn't fit in 16 bits ends the key (so two such
+// characters can't be mistaken for equal and the rest compared).
+inline uint64_t stringSortKey(const wxString& text) {
+
+    uint64_t key = 0;
+    int shift = 48;
+
+    for (auto c = text.begin(); c != text.end() && shift >= 0; ++c, shift -= 16) {
+
+        uint64_t ch = wxUniChar(*c).GetValue();
+
+        if (ch >= 0xFFFF) {
+            key |= uint64_t(0xFFFF) << shift;
+            break;
+        }
+
+        key |= ch << shift;
+    }
+
+    return key;
+}
+
+
+// Comparator for a column built at compile time from the member it shows,
+// in the form SortItems takes (client data is a pointer to the row)
+template <auto Member>
+struct SortColumn {
+
+    using Row = typename MemberTraits<decltype(Member)>::Class;
+
+    static int wxCALLBACK compare(wxIntPtr item1, wxIntPtr item2, wxIntPtr direction) {
+
+        const auto& a = reinterpret_cast<const Row*>(item1)->*Member;
+        const auto& b = reinterpret_cast<const Row*>(item2)->*Member;
+
+        return compareValues(a, b) * static_cast<int>(direction);
+    }
+};
+
+
+// As SortColumn, but an integer key precomputed per row (see
+// stringSortKey) settles most comparisons - the member itself is only
+// compared on equal keys
+template <auto Member, auto Key>
+struct KeyedSortColumn {
+
+    using Row = typename MemberTraits<decltype(Member)>::Class;
+
+    // Fill every row's key before sorting on this column
+    static void prepare(Row& row) { row.*Key = stringSortKey(row.*Member); }
+
+    static int wxCALLBACK compare(wxIntPtr item1, wxIntPtr item2, wxIntPtr direction) {
+
+        const Row* a = reinterpret_cast<const Row*>(item1);
+        const Row* b = reinterpret_cast<const Row*>(item2);
+
+        int order = compareValues(a->*Key, b->*Key);
+
+        if (order == 0) {
+            order = compareValues(a->*Member, b->*Member);
+        }
+
+        return order * static_cast<int>(direction);
+    }
+};
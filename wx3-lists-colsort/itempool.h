@@ -0,0 +1,160 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+#include <cstdint>
+
+
+// Handle to an object in a SlabPool.  The generation is bumped when the
+// slot is released, so a handle kept past release() no longer resolves.
+struct PoolHandle {
+
+    uint32_t    index{ UINT32_MAX };
+    uint32_t    generation{ 0 };
+
+    bool operator==(const PoolHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const PoolHandle& other) const { return !(*this == other); }
+};
+
+
+// Objects allocated from large contiguous slabs.  Addresses never move (a
+// slab is never reallocated), which is what the list's client data needs,
+// but a million rows cost a few hundred allocations instead of a million
+// plus hash buckets.  Freed slots are reused through a free list.
+template <typename T>
+class SlabPool {
+
+public:
+
+    static constexpr uint32_t SlabSize = 4096;
+
+    SlabPool() = default;
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    ~SlabPool() {
+
+        clear();
+    }
+
+    size_t size() const { return live; }
+
+    // Room for count objects without further slab allocations
+    void reserve(size_t count) {
+
+        while (static_cast<size_t>(slabs.size()) * SlabSize < count) {
+            slabs.push_back(std::make_unique<Slot[]>(SlabSize));
+        }
+    }
+
+    // Construct a T (aggregate initialised from args)
+    template <typename... Args>
+    PoolHandle create(Args&&... args) {
+
+        uint32_t index;
+
+        if (freeHead != UINT32_MAX) {
+            index = freeHead;
+            freeHead = slot(index).nextFree;
+        }
+        else {
+
+            if (used == slabs.size() * SlabSize) {
+                slabs.push_back(std::make_unique<Slot[]>(SlabSize));
+            }
+
+            index = used++;
+        }
+
+        Slot& s = slot(index);
+        new (s.storage) T{ std::forward<Args>(args)... };
+
+        s.generation++;     // odd - in use
+        live++;
+
+        return { index, s.generation };
+    }
+
+    // Object for a handle, nullptr if it has been released
+    T* get(PoolHandle handle) {
+
+        if (handle.index >= used || slot(handle.index).generation != handle.generation) {
+            return nullptr;
+        }
+
+        return slot(handle.index).object();
+    }
+
+    void release(PoolHandle handle) {
+
+        if (!get(handle)) {
+            return;
+        }
+
+        Slot& s = slot(handle.index);
+        s.object()->~T();
+
+        s.generation++;     // even - free
+        s.nextFree = freeHead;
+        freeHead = handle.index;
+        live--;
+    }
+
+    // Visit live objects in slab order (memory order)
+    template <typename Visit>
+    void forEach(Visit visit) {
+
+        for (uint32_t index = 0; index < used; index++) {
+
+            Slot& s = slot(index);
+
+            if (s.generation & 1) {
+                visit(*s.object());
+            }
+        }
+    }
+
+    // Destroy everything, keeping the slabs for reuse
+    void clear() {
+
+        for (uint32_t index = 0; index < used; index++) {
+
+            Slot& s = slot(index);
+
+            if (s.generation & 1) {
+                s.object()->~T();
+                s.generation++;
+            }
+        }
+
+        used = 0;
+        live = 0;
+        freeHead = UINT32_MAX;
+    }
+
+    size_t memoryBytes() const {
+
+        return slabs.size() * (SlabSize * sizeof(Slot)) + slabs.capacity() * sizeof(void*);
+    }
+
+private:
+
+    struct Slot {
+
+        alignas(T) unsigned char storage[sizeof(T)];
+        uint32_t    generation{ 0 };    // odd while in use
+        uint32_t    nextFree{ UINT32_MAX };
+
+        T* object() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    uint32_t used{ 0 };             // slots handed out at least once
+    uint32_t freeHead{ UINT32_MAX };
+    size_t live{ 0 };
+
+    Slot& slot(uint32_t index) { return slabs[index / SlabSize][index % SlabSize]; }
+    const Slot& slot(uint32_t index) const { return slabs[index / SlabSize][index % SlabSize]; }
+};
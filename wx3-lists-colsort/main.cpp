@@ -1,7 +1,12 @@
 #include <wx/wx.h>
 #include <wx/listctrl.h>
-#include <unordered_set>
 #include <memory>
+#include <vector>
+#include <span>
+
+#include "itempool.h"
+#include "columnsort.h"
+#include "adaptivelist.h"
 
 
 using namespace std;
@@ -19,18 +24,28 @@ struct ItemData {
     int         id;
     wxString    name;
     wxString    description;
+
+    uint64_t    sortKey{ 0 };   // integer key for the column being sorted (see columnsort.h)
 };
 
 
+// Comparators for each column - strings are compared in place, never copied
+using IdColumn = SortColumn<&ItemData::id>;
+using NameColumn = KeyedSortColumn<&ItemData::name, &ItemData::sortKey>;
+using DescriptionColumn = KeyedSortColumn<&ItemData::description, &ItemData::sortKey>;
+
+
 class ListFrame : public wxFrame {
 
 private:
 
-    wxListView* basicListView;
+    // a wxListView, virtual once it holds many rows
+    AdaptiveListView<ItemData>* basicListView;
     int sortDirection = 1;
 
     // Our list model (preserves pointers linked to wxListView item's client/meta-data)
-    unordered_set<unique_ptr<ItemData>> itemCollection;
+    // - rows live in contiguous slabs, so their addresses never change
+    SlabPool<ItemData> itemCollection;
 
 public:
 
@@ -46,29 +61,33 @@ public:
 
 
         // Create list - report style with columns (different approach for icon views etc - see online docs)
-        basicListView = new wxListView(panel, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT);
+        basicListView = new AdaptiveListView<ItemData>(panel, &ListFrame::cellText);
 
         
-        // Setup columns
-        basicListView->AppendColumn("ID");  // column 0
-        basicListView->AppendColumn("Name"); // column 1
-        basicListView->AppendColumn("Description"); // column 2
-
-        // Configure column widths
-        basicListView->SetColumnWidth(0, 80);
-        basicListView->SetColumnWidth(1, 120);
-        basicListView->SetColumnWidth(2, 600);
+        // Setup columns and widths
+        basicListView->appendColumn("ID", 80);  // column 0
+        basicListView->appendColumn("Name", 120); // column 1
+        basicListView->appendColumn("Description", 600); // column 2
 
         populateListView(); // example build model and set in list
 
-        basicListView->Bind(wxEVT_LIST_COL_CLICK, &ListFrame::sortByColumn, this);
+        basicListView->Bind(wxEVT_LIST_COL_CLICK, &ListFrame::sortByColumn, this); // list events propagate up from the control
 
         sizer->Add(basicListView, 1, wxALL | wxEXPAND, 0);
 
 
+        wxBoxSizer* buttons = new wxBoxSizer(wxHORIZONTAL);
+        sizer->Add(buttons, 0, wxALIGN_LEFT | wxTOP | wxBOTTOM | wxLEFT, 5);
+
         auto button = new wxButton(panel, wxID_ANY, "Sort By ID");
         button->Bind(wxEVT_BUTTON, &ListFrame::sortByID, this);
-        sizer->Add(button, 0, wxALIGN_LEFT | wxTOP | wxBOTTOM | wxLEFT, 5);
+        buttons->Add(button, 0, wxRIGHT, 5);
+
+        auto loadButton = new wxButton(panel, wxID_ANY, "Load 100K Rows");
+        loadButton->Bind(wxEVT_BUTTON, [this](wxCommandEvent& event) { compareLoads(100000); });
+        buttons->Add(loadButton, 0);
+
+        CreateStatusBar();
 
     }
 
@@ -94,71 +113,114 @@ private:
     // Build view and model from raw data
     void insertListItem(int id, const wxString& name, const wxString& desc) {
 
-        int index = basicListView->GetItemCount(); // insert at end of list (see above notes)
+        // Model
+        // can only store a pointer in client data, so the item is owned by
+        // our own collection outside wxWidgets - the pool keeps its address stable
+        // NOT A FULL MODEL - NO SORTING OCCURS ON THIS MODEL ONLY IN VIEW
+        PoolHandle handle = itemCollection.create(id, name, desc); // corresponding data item
+
+        // View - inserted with text for each column and the pointer as
+        // client/meta-data, at the end or, once sorted, at its sorted
+        // position (see AdaptiveListView)
+        basicListView->add(itemCollection.get(handle));
+    }
 
-        // View  (wxListView manages container for multiple items to display)
-        basicListView->InsertItem(index, to_string(id));
-        basicListView->SetItem(index, 1, name);
-        basicListView->SetItem(index, 2, desc);
 
+    // Bulk load - model storage is reserved once and the rows go to the
+    // list in one batch (a frozen control, or straight to the virtual list)
+    void insertListItems(std::span<const ItemData> rows) {
 
-        // Model
-        ItemData data{ id, name, desc }; // corresponding data item
-        auto dataPtr = std::make_unique<ItemData>(data); // single-ownership pointer to (local) data
-        //MUST SET PTR DATA SO CALL SetItemPtrData - NOT JUST AN INT 
-        basicListView->SetItemPtrData(index, reinterpret_cast<wxUIntPtr>(dataPtr.get())); // set pointer as listview item client/meta-data
-
-        // okay, can only store pointer in client data, but need to 
-        // avoid dataPtr going out of scope at end of function - so we're essentially
-        // maintaining our own list outside wxWidgets.  Add here...
-        // NOT A FULL MODEL - NO SORTING OCCURS ON THIS MODEL ONLY IN VIEW
-        itemCollection.insert(std::move(dataPtr)); // ownership passes to itemCollection (move utility func to force dataPtr to rValue)
+        itemCollection.reserve(itemCollection.size() + rows.size());
+
+        std::vector<ItemData*> added;
+        added.reserve(rows.size());
+
+        for (const ItemData& row : rows) {
+
+            PoolHandle handle = itemCollection.create(row.id, row.name, row.description);
+            added.push_back(itemCollection.get(handle));
+        }
+
+        basicListView->add(added);
     }
 
+    void clearList() {
 
-    // Function to sort by a given column (list event handler)
-    void sortByColumn(wxListEvent& event) {
+        basicListView->clear();
+        itemCollection.clear();
+    }
 
-        int foo = 10;
+    // Cell text for the list (formatted on demand once it is virtual)
+    static wxString cellText(const ItemData& row, long column) {
 
-        auto bar = reinterpret_cast<wxIntPtr*>(foo);
+        switch (column) {
+        case 0:
+            return wxString::Format("%d", row.id);
+        case 1:
+            return row.name;
+        case 2:
+            return row.description;
+        default:
+            return wxString();
+        }
+    }
 
-        int columnIndex = event.GetColumn();
+    // Time loading count rows into a normal list one at a time
+    // (insertListItem) and in bulk, then in bulk letting the list go
+    // virtual - the rows from the last load stay in the list
+    void compareLoads(int count) {
 
-        static auto idSort = [](wxIntPtr item1, wxIntPtr item2, wxIntPtr direction)->int {
+        std::vector<ItemData> rows;
+        rows.reserve(count);
 
-            int i1 = reinterpret_cast<ItemData*>(item1)->id;
-            int i2 = reinterpret_cast<ItemData*>(item2)->id;
-            int dir = static_cast<int>(direction);
+        for (int i = 0; i < count; i++) {
+            rows.push_back({ (i * 7919) % count, wxString::Format("Item %d", i), wxString::Format("Description of item %d", i) });
+        }
 
-            return (i1 == i2) ? 0 : (i1 < i2) ? -dir : dir;
-            };
+        auto timeLoad = [this](size_t threshold, auto load) {
 
-        static auto nameSort = [](wxIntPtr item1, wxIntPtr item2, wxIntPtr direction)->int {
+            clearList();
+            basicListView->setVirtualThreshold(threshold);
 
-            auto s1 = reinterpret_cast<ItemData*>(item1)->name;
-            auto s2 = reinterpret_cast<ItemData*>(item2)->name;
+            wxStopWatch timer;
 
-            return s1.compare(s2) * static_cast<int>(direction);
-            };
+            load();
+            basicListView->Update();
 
-        static auto descriptionSort = [](wxIntPtr item1, wxIntPtr item2, wxIntPtr direction)->int {
+            return timer.Time();
+        };
 
-            auto s1 = reinterpret_cast<ItemData*>(item1)->description;
-            auto s2 = reinterpret_cast<ItemData*>(item2)->description;
+        long singleMs = timeLoad(SIZE_MAX, [&]() {
+            for (const ItemData& row : rows) {
+                insertListItem(row.id, row.name, row.description);
+            }
+            });
+
+        long bulkMs = timeLoad(SIZE_MAX, [&]() { insertListItems(rows); });
+        long virtualMs = timeLoad(AdaptiveListView<ItemData>::DefaultThreshold, [&]() { insertListItems(rows); });
+
+        SetStatusText(wxString::Format("%d rows: one at a time %ldms (%.2fus/row), bulk %ldms (%.2fus/row), bulk virtual %ldms (%.2fus/row)",
+            count, singleMs, singleMs * 1000.0 / count, bulkMs, bulkMs * 1000.0 / count, virtualMs, virtualMs * 1000.0 / count));
+    }
+
+
+    // Function to sort by a given column (list event handler)
+    void sortByColumn(wxListEvent& event) {
+
+        int columnIndex = event.GetColumn();
 
-            return s1.compare(s2) * static_cast<int>(direction);
-            };
 
+        // keyed columns have the list fill each row's key (also for rows
+        // added later) - not needed when it only has to reverse
         switch (columnIndex) {
         case 0:
-            basicListView->SortItems(idSort, sortDirection);
+            basicListView->sort(0, IdColumn::compare, sortDirection);
             break;
         case 1:
-            basicListView->SortItems(nameSort, sortDirection);
+            basicListView->sort(1, NameColumn::compare, sortDirection, NameColumn::prepare);
             break;
         case 2:
-            basicListView->SortItems(descriptionSort, sortDirection);
+            basicListView->sort(2, DescriptionColumn::compare, sortDirection, DescriptionColumn::prepare);
             break;
         default:
             return;
@@ -173,7 +235,8 @@ private:
     void sortByID(wxCommandEvent& event) {
 
         // Sort list based on client (meta) data set with SetItemData method
-        basicListView->SortItems(
+        // (same order as the ID column, so it toggles with it)
+        basicListView->sort(0,
             [](wxIntPtr item1, wxIntPtr item2, wxIntPtr direction)->int {
 
                 // This version stores ItemData* in client/meta data - so need to pull out if we want functioning button
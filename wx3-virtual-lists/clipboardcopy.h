@@ -0,0 +1,269 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <wx/clipbrd.h>
+#include <wx/dataobj.h>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "listmodel.h"
+#include "exporter.h"
+
+
+// Rows serialized for the clipboard, kept as a list of chunks so nothing
+// ever has to be one giant allocation.  Bytes are already in the
+// clipboard's native text encoding (UTF-16 on Windows, UTF-8 elsewhere).
+struct ClipboardChunks {
+
+    std::vector<std::string> chunks;
+    size_t bytes{ 0 };
+    size_t rows{ 0 };
+};
+
+
+// Text offered to the clipboard without building it up front - the
+// clipboard asks for the size and then the bytes only when something is
+// pasted, and the chunks are copied straight into its buffer
+class ChunkedTextDataObject : public wxDataObjectSimple {
+
+public:
+
+    explicit ChunkedTextDataObject(std::shared_ptr<const ClipboardChunks> text) : wxDataObjectSimple(wxDataFormat(wxDF_UNICODETEXT)), text(text) {}
+
+    size_t GetDataSize() const override {
+
+        return text->bytes + Terminator;
+    }
+
+    bool GetDataHere(void* buf) const override {
+
+        char* out = static_cast<char*>(buf);
+
+        for (auto& chunk : text->chunks) {
+            std::memcpy(out, chunk.data(), chunk.size());
+            out += chunk.size();
+        }
+
+        std::memset(out, 0, Terminator);
+        return true;
+    }
+
+    bool SetData(size_t len, const void* buf) override {
+
+        return false; // offer only
+    }
+
+private:
+
+#ifdef __WXMSW__
+    static constexpr size_t Terminator = sizeof(wchar_t);
+#else
+    static constexpr size_t Terminator = 0;
+#endif
+
+    std::shared_ptr<const ClipboardChunks> text;
+};
+
+
+// Copies selected rows to the clipboard as tab separated text.  The rows
+// (view indices, through a copy of the view permutation) are serialized
+// on a worker thread into ~1MB chunks; the UI gets progress and, at the
+// end, puts a ChunkedTextDataObject on the clipboard.  Callbacks are
+// delivered on the UI thread via notify->CallAfter.
+class ClipboardCopier {
+
+public:
+
+    // Selected positions in rows - [first, last] inclusive
+    using Ranges = std::vector<std::pair<size_t, size_t>>;
+
+    using ProgressCallback = std::function<void(size_t done, size_t total)>;
+    using DoneCallback = std::function<void(bool ok, const wxString& message)>;
+
+    static constexpr size_t ChunkSize = 1024 * 1024;
+
+    ~ClipboardCopier() {
+
+        cancel();
+    }
+
+    bool isRunning() const { return running; }
+
+    // rows maps positions to model rows (usually a copy of model.view)
+    bool start(ListModel& model, std::vector<size_t> rows, Ranges ranges,
+        wxEvtHandler* notify, ProgressCallback onProgress, DoneCallback onDone) {
+
+        if (running) {
+            return false;
+        }
+
+        join();
+
+        cancelled = false;
+        running = true;
+        model.backgroundReaders++;
+
+        worker = std::thread([this, &model, rows = std::move(rows), ranges = std::move(ranges), notify, onProgress, onDone]() {
+
+            auto text = std::make_shared<ClipboardChunks>();
+            serialize(model, rows, ranges, *text, notify, onProgress);
+
+            model.backgroundReaders--;
+
+            bool ok = !cancelled;
+
+            notify->CallAfter([this, text, ok, onDone]() {
+
+                running = false;
+
+                if (!ok) {
+                    onDone(false, "Copy cancelled");
+                    return;
+                }
+
+                wxClipboardLocker locker;
+
+                if (!locker) {
+                    onDone(false, "Could not open the clipboard");
+                    return;
+                }
+
+                wxTheClipboard->SetData(new ChunkedTextDataObject(text));
+                onDone(true, wxString::Format("Copied %zu rows (%.1f MB)", text->rows, text->bytes / 1048576.0));
+                });
+            });
+
+        return true;
+    }
+
+    // Stop a running copy (waits for the worker to finish)
+    void cancel() {
+
+        cancelled = true;
+        join();
+    }
+
+private:
+
+    std::thread worker;
+    std::atomic<bool> running{ false };
+    std::atomic<bool> cancelled{ false };
+
+    void join() {
+
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    // Cell text in the clipboard encoding - tabs/newlines become spaces so
+    // the row/column structure survives
+    static void appendCell(std::string& out, const wxString& s) {
+
+#ifdef __WXMSW__
+        for (wchar_t c : s) {
+
+            if (c == '\t' || c == '\n' || c == '\r') {
+                c = ' ';
+            }
+
+            out.append(reinterpret_cast<const char*>(&c), sizeof(c));
+        }
+#else
+        size_t start = out.size();
+        appendUtf8(out, s);
+
+        // UTF-8 never uses ASCII bytes inside a multi-byte character
+        for (size_t i = start; i < out.size(); i++) {
+            if (out[i] == '\t' || out[i] == '\n' || out[i] == '\r') {
+                out[i] = ' ';
+            }
+        }
+#endif
+    }
+
+    static void appendAscii(std::string& out, const char* s, size_t length) {
+
+#ifdef __WXMSW__
+        for (size_t i = 0; i < length; i++) {
+            wchar_t c = s[i];
+            out.append(reinterpret_cast<const char*>(&c), sizeof(c));
+        }
+#else
+        out.append(s, length);
+#endif
+    }
+
+    static void appendRow(std::string& out, const ItemData& item) {
+
+        std::string id;
+        RowFormat::appendInt(id, item.id);
+
+        appendAscii(out, id.data(), id.size());
+        appendAscii(out, "\t", 1);
+        appendCell(out, item.name);
+        appendAscii(out, "\t", 1);
+        appendCell(out, item.description);
+        appendAscii(out, "\n", 1);
+    }
+
+    void serialize(const ListModel& model, const std::vector<size_t>& rows, const Ranges& ranges,
+        ClipboardChunks& text, wxEvtHandler* notify, const ProgressCallback& onProgress) {
+
+        RowCursor cursor(model);
+
+        size_t total = 0;
+
+        for (auto& range : ranges) {
+            total += range.second - range.first + 1;
+        }
+
+        const size_t progressStep = std::max<size_t>(total / 100, 16 * 1024);
+        size_t nextProgress = progressStep;
+        size_t done = 0;
+
+        std::string chunk;
+        chunk.reserve(ChunkSize + 64 * 1024);
+
+        for (auto& range : ranges) {
+
+            for (size_t i = range.first; i <= range.second; i++) {
+
+                appendRow(chunk, cursor[rows[i]]);
+                done++;
+
+                if (chunk.size() >= ChunkSize) {
+
+                    text.bytes += chunk.size();
+                    text.chunks.push_back(std::move(chunk));
+
+                    chunk = std::string();
+                    chunk.reserve(ChunkSize + 64 * 1024);
+                }
+
+                if (done == nextProgress) {
+
+                    if (cancelled) {
+                        return;
+                    }
+
+                    nextProgress += progressStep;
+
+                    notify->CallAfter([onProgress, done, total]() {
+                        onProgress(done, total);
+                        });
+                }
+            }
+        }
+
+        chunk.shrink_to_fit();
+        text.bytes += chunk.size();
+        text.chunks.push_back(std::move(chunk));
+        text.rows = done;
+    }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+
+#include "memoryusage.h"
+
+
+// What each list column shows, in list order.  Wide tables have hundreds
+// of columns, so an entry is 12 bytes - titles are packed into one UTF-8
+// buffer instead of a string per column.
+class ColumnSchema {
+
+public:
+
+    enum class Kind : uint8_t { Model, Computed };
+
+    size_t size() const { return entries.size(); }
+
+    // source: the model column, or the index of the computed column
+    void add(Kind kind, uint32_t source, const wxString& title) {
+
+        Entry entry;
+        entry.titleOffset = static_cast<uint32_t>(titles.size());
+        entry.kind = kind;
+        entry.fitted = 0;
+        entry.source = source;
+
+        titles += std::string(title.utf8_str());
+        entry.titleLength = static_cast<uint16_t>(std::min<size_t>(titles.size() - entry.titleOffset, UINT16_MAX));
+
+        entries.push_back(entry);
+    }
+
+    Kind kind(int column) const { return entries[column].kind; }
+    uint32_t source(int column) const { return entries[column].source; }
+
+    wxString title(int column) const {
+
+        return wxString::FromUTF8(titles.data() + entries[column].titleOffset, entries[column].titleLength);
+    }
+
+    // Sized to content yet (see VirtualList::fitVisibleColumns)
+    bool isFitted(int column) const { return entries[column].fitted != 0; }
+    void setFitted(int column, bool fitted = true) { entries[column].fitted = fitted; }
+
+    size_t memoryBytes() const {
+
+        return MemoryUsage::vectorBytes(entries) + (titles.capacity() > 15 ? titles.capacity() + 1 + MemoryUsage::AllocationOverhead : 0);
+    }
+
+private:
+
+    struct Entry {
+
+        uint32_t    titleOffset;
+        uint16_t    titleLength;
+        Kind        kind;
+        uint8_t     fitted;
+        uint32_t    source;
+    };
+
+    static_assert(sizeof(Entry) == 12, "column entries are kept small");
+
+    std::vector<Entry> entries;
+    std::string titles;
+};
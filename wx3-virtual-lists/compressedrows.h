@@ -0,0 +1,175 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <vector>
+#include <string>
+#include <thread>
+#include <memory>
+#include <cstring>
+
+#include "itemdata.h"
+#include "rowsource.h"
+#include "lzblock.h"
+#include "exporter.h"
+
+
+// Rows held in memory with the name and description columns compressed
+// in blocks of BlockRows rows (ids stay uncompressed).  A block's text is
+// stored as UTF-8 with a uint32 length before each string, then LZ
+// compressed as a unit.  ListModel's block cache keeps a few decoded
+// blocks in front of the list.
+class CompressedRows : public RowSource {
+
+public:
+
+    // Build from rows (in parallel, one range of blocks per core)
+    static std::unique_ptr<CompressedRows> build(const std::vector<ItemData>& rows) {
+
+        auto compressed = std::unique_ptr<CompressedRows>(new CompressedRows());
+
+        size_t blockCount = (rows.size() + BlockRows - 1) / BlockRows;
+
+        compressed->ids.resize(rows.size());
+        compressed->blocks.resize(blockCount);
+
+        for (size_t i = 0; i < rows.size(); i++) {
+            compressed->ids[i] = rows[i].id;
+        }
+
+        size_t threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), blockCount));
+        std::vector<std::thread> workers;
+
+        for (size_t t = 0; t < threads; t++) {
+
+            workers.emplace_back([&, t]() {
+
+                std::string text;
+
+                for (size_t block = t; block < blockCount; block += threads) {
+                    compressed->compressBlock(rows, block, text);
+                }
+                });
+        }
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        return compressed;
+    }
+
+    size_t rowCount() const override { return ids.size(); }
+
+    // Decoded blocks kept in front of the list - kept small, that's the point
+    size_t cacheBlocks() const override { return 32; }
+
+    void decodeBlock(size_t block, std::vector<ItemData>& rows) const override {
+
+        const Block& b = blocks[block];
+
+        std::string text(b.textSize, '\0');
+
+        if (!LzBlock::decompress(b.data.data(), b.data.size(), text.data(), text.size())) {
+            wxFAIL_MSG("corrupt compressed block");
+            text.assign(b.textSize, '\0');
+        }
+
+        size_t first = block * BlockRows;
+        size_t last = std::min(first + BlockRows, ids.size());
+
+        rows.clear();
+        rows.reserve(last - first);
+
+        const char* p = text.data();
+
+        for (size_t row = first; row < last; row++) {
+
+            ItemData item;
+            item.id = ids[row];
+            item.name = readString(p);
+            item.description = readString(p);
+
+            rows.push_back(std::move(item));
+        }
+    }
+
+    // Bytes used by the compressed text and the ids
+    size_t compressedBytes() const {
+
+        size_t total = ids.size() * sizeof(int32_t) + blocks.size() * sizeof(Block);
+
+        for (auto& b : blocks) {
+            total += b.data.capacity();
+        }
+
+        return total;
+    }
+
+    void memoryUsage(MemoryUsage& usage) const override {
+
+        size_t text = MemoryUsage::vectorBytes(blocks);
+
+        for (auto& b : blocks) {
+            text += b.data.capacity() + MemoryUsage::AllocationOverhead;
+        }
+
+        usage.add("Column", "id (compressed store)", MemoryUsage::vectorBytes(ids));
+        usage.add("Column", "name + description (compressed)", text);
+    }
+
+    // Bytes of the (UTF-8) text before compression
+    size_t textBytes() const {
+
+        size_t total = 0;
+
+        for (auto& b : blocks) {
+            total += b.textSize;
+        }
+
+        return total;
+    }
+
+private:
+
+    struct Block {
+
+        std::string data;       // compressed
+        uint32_t    textSize;   // decompressed
+    };
+
+    std::vector<int32_t> ids;
+    std::vector<Block> blocks;
+
+    CompressedRows() = default;
+
+    void compressBlock(const std::vector<ItemData>& rows, size_t block, std::string& text) {
+
+        size_t first = block * BlockRows;
+        size_t last = std::min(first + BlockRows, rows.size());
+
+        text.clear();
+
+        for (size_t row = first; row < last; row++) {
+            RowFormat::appendSized(text, rows[row].name);
+            RowFormat::appendSized(text, rows[row].description);
+        }
+
+        Block& b = blocks[block];
+        b.textSize = static_cast<uint32_t>(text.size());
+
+        LzBlock::compress(text.data(), text.size(), b.data);
+        b.data.shrink_to_fit();
+    }
+
+    static wxString readString(const char*& p) {
+
+        uint32_t length;
+        std::memcpy(&length, p, sizeof(length));
+        p += sizeof(length);
+
+        wxString s = wxString::FromUTF8(p, length);
+        p += length;
+
+        return s;
+    }
+};
@@ -0,0 +1,786 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <wx/hashmap.h>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+
+#include "listmodel.h"
+
+
+// Values of one expression for a batch of rows - numbers or texts
+struct ValueColumn {
+
+    enum class Type { Number, Text };
+
+    Type type{ Type::Number };
+    std::vector<int64_t> numbers;
+    std::vector<wxString> texts;
+};
+
+
+// Compiled expression.  Every node works on a whole batch of rows at once:
+// a field node gathers its column for the batch, operators run one tight
+// loop over their children's arrays - no per-row tree walk.
+class ExprNode {
+
+public:
+
+    virtual ~ExprNode() = default;
+
+    ValueColumn::Type type{ ValueColumn::Type::Number };
+
+    // Values for model rows (out is reused between batches)
+    virtual void eval(const ListModel& model, const std::vector<size_t>& rows, ValueColumn& out) const = 0;
+
+protected:
+
+    static void reset(ValueColumn& out, ValueColumn::Type type, size_t size) {
+
+        out.type = type;
+
+        if (type == ValueColumn::Type::Number) {
+            out.numbers.resize(size);
+            out.texts.clear();
+        }
+        else {
+            out.texts.resize(size);
+            out.numbers.clear();
+        }
+    }
+};
+
+
+namespace Expr {
+
+    using Node = std::unique_ptr<ExprNode>;
+    using Type = ValueColumn::Type;
+
+    // id, name or description
+    class Field : public ExprNode {
+
+    public:
+
+        explicit Field(int column) : column(column) { type = (column == 0) ? Type::Number : Type::Text; }
+
+        void eval(const ListModel& model, const std::vector<size_t>& rows, ValueColumn& out) const override {
+
+            reset(out, type, rows.size());
+
+            for (size_t i = 0; i < rows.size(); i++) {
+
+                const ItemData& item = model.row(rows[i]);
+
+                switch (column) {
+                case 0: out.numbers[i] = item.id; break;
+                case 1: out.texts[i] = item.name; break;
+                default: out.texts[i] = item.description; break;
+                }
+            }
+        }
+
+    private:
+
+        int column;
+    };
+
+    class Number : public ExprNode {
+
+    public:
+
+        explicit Number(int64_t value) : value(value) {}
+
+        const int64_t value;
+
+        void eval(const ListModel& model, const std::vector<size_t>& rows, ValueColumn& out) const override {
+
+            reset(out, Type::Number, 0);
+            out.numbers.assign(rows.size(), value);
+        }
+    };
+
+    class Text : public ExprNode {
+
+    public:
+
+        explicit Text(const wxString& value) : value(value) { type = Type::Text; }
+
+        void eval(const ListModel& model, const std::vector<size_t>& rows, ValueColumn& out) const override {
+
+            reset(out, Type::Text, 0);
+            out.texts.assign(rows.size(), value);
+        }
+
+    private:
+
+        wxString value;
+    };
+
+    // len(text)
+    class Length : public ExprNode {
+
+    public:
+
+        explicit Length(Node arg) : arg(std::move(arg)) {}
+
+        void eval(const ListModel& model, const std::vector<size_t>& rows, ValueColumn& out) const override {
+
+            ValueColumn in;
+            arg->eval(model, rows, in);
+
+            reset(out, Type::Number, rows.size());
+
+            for (size_t i = 0; i < rows.size(); i++) {
+                out.numbers[i] = static_cast<int64_t>(in.texts[i].length());
+            }
+        }
+
+    private:
+
+        Node arg;
+    };
+
+    // upper(text) / lower(text)
+    class Case : public ExprNode {
+
+    public:
+
+        Case(Node arg, bool upper) : arg(std::move(arg)), upper(upper) { type = Type::Text; }
+
+        void eval(const ListModel& model, const std::vector<size_t>& rows, ValueColumn& out) const override {
+
+            arg->eval(model, rows, out);
+
+            for (auto& text : out.texts) {
+                upper ? text.MakeUpper() : text.MakeLower();
+            }
+        }
+
+    private:
+
+        Node arg;
+        bool upper;
+    };
+
+    // concat(a, b, ...) and text + anything - numbers are formatted
+    class Concat : public ExprNode {
+
+    public:
+
+        explicit Concat(std::vector<Node> args) : args(std::move(args)) { type = Type::Text; }
+
+        void eval(const ListModel& model, const std::vector<size_t>& rows, ValueColumn& out) const override {
+
+            reset(out, Type::Text, 0);
+            out.texts.assign(rows.size(), wxString());
+
+            ValueColumn in;
+
+            for (auto& arg : args) {
+
+                arg->eval(model, rows, in);
+
+                for (size_t i = 0; i < rows.size(); i++) {
+
+                    if (in.type == Type::Number) {
+                        out.texts[i] << in.numbers[i];
+                    }
+                    else {
+                        out.texts[i] += in.texts[i];
+                    }
+                }
+            }
+        }
+
+    private:
+
+        std::vector<Node> args;
+    };
+
+    // Arithmetic on numbers (x / 0 and x % 0 give 0, overflow wraps around
+    // as two's complement - INT64_MAX + 1 is INT64_MIN, never undefined)
+    class Arithmetic : public ExprNode {
+
+    public:
+
+        Arithmetic(char op, Node left, Node right) : op(op), left(std::move(left)), right(std::move(right)) {}
+
+        void eval(const ListModel& model, const std::vector<size_t>& rows, ValueColumn& out) const override {
+
+            ValueColumn rhs;
+            left->eval(model, rows, out);
+            right->eval(model, rows, rhs);
+
+            int64_t* a = out.numbers.data();
+            const int64_t* b = rhs.numbers.data();
+            size_t n = rows.size();
+
+            // one loop per operator so each is a simple (vectorizable) loop;
+            // + - * in unsigned, where overflow is defined
+            switch (op) {
+            case '+': for (size_t i = 0; i < n; i++) a[i] = number(bits(a[i]) + bits(b[i])); break;
+            case '-': for (size_t i = 0; i < n; i++) a[i] = number(bits(a[i]) - bits(b[i])); break;
+            case '*': for (size_t i = 0; i < n; i++) a[i] = number(bits(a[i]) * bits(b[i])); break;
+            case '/': for (size_t i = 0; i < n; i++) a[i] = divide(a[i], b[i]); break;
+            case '%': for (size_t i = 0; i < n; i++) a[i] = remainder(a[i], b[i]); break;
+            }
+        }
+
+    private:
+
+        static uint64_t bits(int64_t value) { return static_cast<uint64_t>(value); }
+        static int64_t number(uint64_t bits) { return static_cast<int64_t>(bits); }
+
+        // INT64_MIN / -1 doesn't fit (and traps) - x / -1 is a wrapping negate
+        static int64_t divide(int64_t a, int64_t b) {
+
+            if (b == 0) {
+                return 0;
+            }
+
+            return (b == -1) ? number(0 - bits(a)) : a / b;
+        }
+
+        static int64_t remainder(int64_t a, int64_t b) {
+
+            return (b == 0 || b == -1) ? 0 : a % b;
+        }
+
+        char op;
+        Node left;
+        Node right;
+    };
+
+    // bucket(number, size) - start of the size-wide bucket holding number
+    class Bucket : public ExprNode {
+
+    public:
+
+        Bucket(Node arg, int64_t size) : arg(std::move(arg)), size(size) {}
+
+        void eval(const ListModel& model, const std::vector<size_t>& rows, ValueColumn& out) const override {
+
+            arg->eval(model, rows, out);
+
+            for (auto& value : out.numbers) {
+
+                // floor, also below zero (wrapping - the bucket below
+                // INT64_MIN is out of range)
+                int64_t q = value / size;
+                value = static_cast<int64_t>(static_cast<uint64_t>((value % size < 0) ? q - 1 : q) * static_cast<uint64_t>(size));
+            }
+        }
+
+    private:
+
+        Node arg;
+        int64_t size;
+    };
+
+
+    // Recursive descent over
+    //   expr    := term (('+' | '-') term)*
+    //   term    := unary (('*' | '/' | '%') unary)*
+    //   unary   := '-' unary | primary
+    //   primary := number | "text" | field | function '(' args ')' | '(' expr ')'
+    class Parser {
+
+    public:
+
+        Parser(const wxString& text, wxString& error) : text(text), error(error) {}
+
+        Node parse() {
+
+            Node node = expression();
+
+            skipSpace();
+
+            if (node && at < text.length()) {
+                return fail(wxString::Format("Unexpected '%s'", text.Mid(at)));
+            }
+
+            return node;
+        }
+
+    private:
+
+        const wxString& text;
+        wxString& error;
+        size_t at{ 0 };
+
+        Node fail(const wxString& message) {
+
+            if (error.IsEmpty()) {
+                error = message;
+            }
+
+            return nullptr;
+        }
+
+        void skipSpace() {
+
+            while (at < text.length() && wxIsspace(text[at])) {
+                at++;
+            }
+        }
+
+        bool accept(wxUniChar c) {
+
+            skipSpace();
+
+            if (at < text.length() && text[at] == c) {
+                at++;
+                return true;
+            }
+
+            return false;
+        }
+
+        Node expression() {
+
+            Node left = term();
+
+            while (left) {
+
+                bool plus = accept('+');
+
+                if (!plus && !accept('-')) {
+                    break;
+                }
+
+                Node right = term();
+
+                if (!right) {
+                    return nullptr;
+                }
+
+                if (plus && (left->type == Type::Text || right->type == Type::Text)) {
+
+                    std::vector<Node> parts;
+                    parts.push_back(std::move(left));
+                    parts.push_back(std::move(right));
+                    left = std::make_unique<Concat>(std::move(parts));
+                }
+                else if (left->type == Type::Number && right->type == Type::Number) {
+                    left = std::make_unique<Arithmetic>(plus ? '+' : '-', std::move(left), std::move(right));
+                }
+                else {
+                    return fail("'-' needs numbers");
+                }
+            }
+
+            return left;
+        }
+
+        Node term() {
+
+            Node left = unary();
+
+            while (left) {
+
+                char op = accept('*') ? '*' : accept('/') ? '/' : accept('%') ? '%' : 0;
+
+                if (!op) {
+                    break;
+                }
+
+                Node right = unary();
+
+                if (!right) {
+                    return nullptr;
+                }
+
+                if (left->type != Type::Number || right->type != Type::Number) {
+                    return fail(wxString::Format("'%c' needs numbers", op));
+                }
+
+                left = std::make_unique<Arithmetic>(op, std::move(left), std::move(right));
+            }
+
+            return left;
+        }
+
+        Node unary() {
+
+            if (!accept('-')) {
+                return primary();
+            }
+
+            Node arg = unary();
+
+            if (!arg) {
+                return nullptr;
+            }
+
+            if (arg->type != Type::Number) {
+                return fail("'-' needs a number");
+            }
+
+            return std::make_unique<Arithmetic>('-', std::make_unique<Number>(0), std::move(arg));
+        }
+
+        Node primary() {
+
+            skipSpace();
+
+            if (at >= text.length()) {
+                return fail("Unexpected end of expression");
+            }
+
+            wxUniChar c = text[at];
+
+            if (accept('(')) {
+
+                Node node = expression();
+
+                if (node && !accept(')')) {
+                    return fail("Missing ')'");
+                }
+
+                return node;
+            }
+
+            if (c == '"') {
+
+                wxString value;
+
+                for (at++; at < text.length() && text[at] != '"'; at++) {
+                    value += text[at];
+                }
+
+                if (!accept('"')) {
+                    return fail("Missing closing '\"'");
+                }
+
+                return std::make_unique<Text>(value);
+            }
+
+            if (wxIsdigit(c)) {
+
+                size_t start = at;
+
+                while (at < text.length() && wxIsdigit(text[at])) {
+                    at++;
+                }
+
+                long long value = 0;
+
+                if (!text.Mid(start, at - start).ToLongLong(&value)) {
+                    return fail("Number too large");
+                }
+
+                return std::make_unique<Number>(value);
+            }
+
+            if (!wxIsalpha(c)) {
+                return fail(wxString::Format("Unexpected '%s'", text.Mid(at)));
+            }
+
+            size_t start = at;
+
+            while (at < text.length() && (wxIsalnum(text[at]) || text[at] == '_')) {
+                at++;
+            }
+
+            wxString name = text.Mid(start, at - start).Lower();
+
+            if (name == "id") return std::make_unique<Field>(0);
+            if (name == "name") return std::make_unique<Field>(1);
+            if (name == "description") return std::make_unique<Field>(2);
+
+            return function(name);
+        }
+
+        Node function(const wxString& name) {
+
+            if (!accept('(')) {
+                return fail(wxString::Format("Unknown field '%s'", name));
+            }
+
+            std::vector<Node> args;
+
+            if (!accept(')')) {
+
+                do {
+                    Node arg = expression();
+
+                    if (!arg) {
+                        return nullptr;
+                    }
+
+                    args.push_back(std::move(arg));
+                } while (accept(','));
+
+                if (!accept(')')) {
+                    return fail("Missing ')'");
+                }
+            }
+
+            auto count = [&](size_t n) { return args.size() == n; };
+
+            if (name == "len" && count(1) && args[0]->type == Type::Text) {
+                return std::make_unique<Length>(std::move(args[0]));
+            }
+
+            if ((name == "upper" || name == "lower") && count(1) && args[0]->type == Type::Text) {
+                return std::make_unique<Case>(std::move(args[0]), name == "upper");
+            }
+
+            if (name == "concat" && !args.empty()) {
+                return std::make_unique<Concat>(std::move(args));
+            }
+
+            if (name == "bucket" && count(2) && args[0]->type == Type::Number) {
+
+                // bucket size must be a positive constant
+                auto size = dynamic_cast<const Number*>(args[1].get());
+
+                if (!size || size->value <= 0) {
+                    return fail("bucket() size must be a positive number");
+                }
+
+                return std::make_unique<Bucket>(std::move(args[0]), size->value);
+            }
+
+            return fail(wxString::Format("Can't use %s() like that - try len(text), upper(text), lower(text), concat(...) or bucket(number, size)", name));
+        }
+    };
+}
+
+
+// A derived column defined by an expression, e.g. len(description),
+// bucket(id, 100) or concat(name, " / ", id).  Nothing is computed up
+// front: values are evaluated a batch at a time for the rows the list
+// shows (or sorts on) and memoized per model row in chunks allocated on
+// first use, so a column nobody scrolls to costs next to nothing.  The
+// memo is dropped when row contents change (ListModel::dataVersion).
+class ComputedColumn : public SortKey {
+
+public:
+
+    static constexpr size_t ChunkRows = RowSource::BlockRows;
+
+    // nullptr (and error set) if the expression doesn't compile
+    static std::shared_ptr<ComputedColumn> compile(const wxString& expression, wxString& error) {
+
+        Expr::Node root = Expr::Parser(expression, error).parse();
+
+        if (!root) {
+            return nullptr;
+        }
+
+        return std::shared_ptr<ComputedColumn>(new ComputedColumn(expression, std::move(root)));
+    }
+
+    const wxString& expression() const { return source; }
+
+    ValueColumn::Type type() const { return root->type; }
+
+    // Text for a view row - on a miss, evaluates the rows of view
+    // [batchFrom, batchTo] that aren't known yet in one batch
+    wxString text(const ListModel& model, long viewIndex, long batchFrom, long batchTo) {
+
+        sync(model);
+
+        size_t row = model.modelRow(viewIndex);
+
+        if (!known(row)) {
+
+            batchFrom = std::max(0L, std::min(batchFrom, viewIndex));
+            batchTo = std::min(static_cast<long>(model.rowCount()) - 1, std::max(batchTo, viewIndex));
+
+            rows.clear();
+
+            for (long i = batchFrom; i <= batchTo; i++) {
+                rows.push_back(model.modelRow(i));
+            }
+
+            prepare(model, rows);
+        }
+
+        return textAt(row);
+    }
+
+    // Text for a model row - on a miss, evaluates the model rows batch()
+    // returns (e.g. the page being drawn) in one go
+    template <typename Batch>
+    wxString text(const ListModel& model, size_t row, Batch batch) {
+
+        sync(model);
+
+        if (!known(row)) {
+
+            prepare(model, batch());
+
+            if (!known(row)) {
+                prepare(model, { row });
+            }
+        }
+
+        return textAt(row);
+    }
+
+    // Text for a model row already evaluated by prepare()
+    wxString textAt(size_t row) const {
+
+        const Chunk& chunk = *chunks[row / ChunkRows];
+        size_t i = row % ChunkRows;
+
+        return (type() == ValueColumn::Type::Number) ? wxString(std::to_string(chunk.numbers[i])) : chunk.texts[i];
+    }
+
+    // Evaluate whichever of rows aren't memoized yet
+    void prepare(const ListModel& model, const std::vector<size_t>& wanted) override {
+
+        sync(model);
+
+        pending.clear();
+
+        for (size_t row : wanted) {
+
+            if (!known(row)) {
+                pending.push_back(row);
+            }
+        }
+
+        // batch size bounds the temporary arrays for a full sort
+        for (size_t start = 0; start < pending.size(); start += ChunkRows) {
+
+            batch.assign(pending.begin() + start, pending.begin() + std::min(pending.size(), start + ChunkRows));
+            root->eval(model, batch, values);
+
+            for (size_t i = 0; i < batch.size(); i++) {
+
+                Chunk& chunk = chunkFor(batch[i]);
+                size_t at = batch[i] % ChunkRows;
+
+                if (values.type == ValueColumn::Type::Number) {
+                    chunk.numbers[at] = values.numbers[i];
+                }
+                else {
+                    chunk.texts[at] = std::move(values.texts[i]);
+                }
+
+                chunk.known[at] = 1;
+            }
+        }
+    }
+
+    bool less(size_t r1, size_t r2) const override {
+
+        const Chunk& c1 = *chunks[r1 / ChunkRows];
+        const Chunk& c2 = *chunks[r2 / ChunkRows];
+
+        if (type() == ValueColumn::Type::Number) {
+            return c1.numbers[r1 % ChunkRows] < c2.numbers[r2 % ChunkRows];
+        }
+
+        return c1.texts[r1 % ChunkRows] < c2.texts[r2 % ChunkRows];
+    }
+
+    // Memoized values (only the chunks evaluated so far)
+    size_t memoryBytes() const {
+
+        size_t bytes = MemoryUsage::vectorBytes(chunks);
+
+        for (auto& chunk : chunks) {
+
+            if (!chunk) {
+                continue;
+            }
+
+            bytes += sizeof(Chunk) + MemoryUsage::AllocationOverhead;
+            bytes += MemoryUsage::vectorBytes(chunk->known) + MemoryUsage::vectorBytes(chunk->numbers) + MemoryUsage::vectorBytes(chunk->texts);
+
+            for (auto& text : chunk->texts) {
+                bytes += MemoryUsage::stringHeapBytes(text);
+            }
+        }
+
+        return bytes;
+    }
+
+    // For grouping rows by value (rows must have been prepared)
+    size_t hash(size_t row) const {
+
+        const Chunk& chunk = *chunks[row / ChunkRows];
+
+        if (type() == ValueColumn::Type::Number) {
+            return std::hash<int64_t>()(chunk.numbers[row % ChunkRows]);
+        }
+
+        return wxStringHash()(chunk.texts[row % ChunkRows]);
+    }
+
+    bool equal(size_t r1, size_t r2) const {
+
+        return !less(r1, r2) && !less(r2, r1);
+    }
+
+private:
+
+    struct Chunk {
+
+        std::vector<uint8_t> known;
+        std::vector<int64_t> numbers;
+        std::vector<wxString> texts;
+    };
+
+    wxString source;
+    Expr::Node root;
+
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    uint64_t cacheVersion{ ~uint64_t{ 0 } };
+    size_t cacheRows{ 0 };
+
+    // Scratch space reused between batches
+    std::vector<size_t> rows;
+    std::vector<size_t> pending;
+    std::vector<size_t> batch;
+    ValueColumn values;
+
+    ComputedColumn(const wxString& expression, Expr::Node root) : source(expression), root(std::move(root)) {}
+
+    // Forget everything when the rows have changed
+    void sync(const ListModel& model) {
+
+        if (cacheVersion == model.dataVersion && cacheRows == model.totalRows()) {
+            return;
+        }
+
+        cacheVersion = model.dataVersion;
+        cacheRows = model.totalRows();
+
+        chunks.clear();
+        chunks.resize((cacheRows + ChunkRows - 1) / ChunkRows);
+    }
+
+    bool known(size_t row) const {
+
+        const auto& chunk = chunks[row / ChunkRows];
+        return chunk && chunk->known[row % ChunkRows];
+    }
+
+    Chunk& chunkFor(size_t row) {
+
+        auto& chunk = chunks[row / ChunkRows];
+
+        if (!chunk) {
+
+            chunk = std::make_unique<Chunk>();
+            chunk->known.assign(ChunkRows, 0);
+
+            if (type() == ValueColumn::Type::Number) {
+                chunk->numbers.resize(ChunkRows);
+            }
+            else {
+                chunk->texts.resize(ChunkRows);
+            }
+        }
+
+        return *chunk;
+    }
+};
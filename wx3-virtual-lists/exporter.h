@@ -0,0 +1,289 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+#include "listmodel.h"
+
+
+enum class ExportFormat {
+
+    CSV,    // UTF-8, one row per line, RFC 4180 quoting
+    Binary  // "WXLB" header then per row: int32 id, (uint32 len + UTF-8 bytes) x 2
+};
+
+
+// Binary export header (little endian, as written by the host)
+struct ExportFileHeader {
+
+    char        magic[4]{ 'W', 'X', 'L', 'B' };
+    uint32_t    formatVersion{ 1 };
+    uint64_t    rowCount{ 0 };
+};
+
+
+// Append a wxString to out as UTF-8 without going through a temporary
+// buffer (wxString::utf8_str allocates for every call)
+inline void appendUtf8(std::string& out, const wxString& s) {
+
+    const wchar_t* p = s.wc_str();
+    const wchar_t* end = p + s.length();
+
+    while (p < end) {
+
+        uint32_t c = static_cast<uint32_t>(*p++);
+
+        if (c < 0x80) {
+            out.push_back(static_cast<char>(c));
+            continue;
+        }
+
+        // UTF-16 surrogate pair (wchar_t is 16 bit on Windows)
+        if (c >= 0xD800 && c <= 0xDBFF && p < end) {
+
+            uint32_t low = static_cast<uint32_t>(*p);
+
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                p++;
+            }
+        }
+
+        if (c < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+        else if (c < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+        else {
+            out.push_back(static_cast<char>(0xF0 | (c >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+    }
+}
+
+
+// Row formatters - append one row to a buffer in the given format
+struct RowFormat {
+
+    static void appendInt(std::string& out, int value) {
+
+        char digits[16];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    static void appendCsvField(std::string& out, const wxString& s) {
+
+        bool quote = false;
+
+        for (wxChar c : s) {
+            if (c == ',' || c == '"' || c == '\n' || c == '\r') {
+                quote = true;
+                break;
+            }
+        }
+
+        if (!quote) {
+            appendUtf8(out, s);
+            return;
+        }
+
+        out.push_back('"');
+
+        // Double any embedded quotes
+        size_t start = out.size();
+        appendUtf8(out, s);
+
+        for (size_t i = start; i < out.size(); i++) {
+            if (out[i] == '"') {
+                out.insert(out.begin() + i, '"');
+                i++;
+            }
+        }
+
+        out.push_back('"');
+    }
+
+    static void csv(std::string& out, const ItemData& item) {
+
+        appendInt(out, item.id);
+        out.push_back(',');
+        appendCsvField(out, item.name);
+        out.push_back(',');
+        appendCsvField(out, item.description);
+        out.push_back('\n');
+    }
+
+    static void appendSized(std::string& out, const wxString& s) {
+
+        // reserve length slot, write bytes, then patch the length in
+        size_t lengthAt = out.size();
+        out.append(sizeof(uint32_t), '\0');
+
+        appendUtf8(out, s);
+
+        uint32_t length = static_cast<uint32_t>(out.size() - lengthAt - sizeof(uint32_t));
+        std::memcpy(&out[lengthAt], &length, sizeof(length));
+    }
+
+    static void binary(std::string& out, const ItemData& item) {
+
+        int32_t id = item.id;
+        out.append(reinterpret_cast<const char*>(&id), sizeof(id));
+        appendSized(out, item.name);
+        appendSized(out, item.description);
+    }
+};
+
+
+// Streams the current view of a ListModel to a file on a worker thread.
+// The view permutation is copied when the export starts, so the user can
+// keep sorting/filtering (and the list keeps painting) while it runs.
+// Callbacks are delivered on the UI thread via notify->CallAfter.
+class ListExporter {
+
+public:
+
+    using ProgressCallback = std::function<void(size_t done, size_t total)>;
+    using DoneCallback = std::function<void(bool ok, const wxString& message)>;
+
+    // Rows are formatted into a reused buffer and written in blocks of this size
+    static constexpr size_t BufferSize = 4 * 1024 * 1024;
+
+    ~ListExporter() {
+
+        cancel();
+    }
+
+    bool isRunning() const { return running; }
+
+    // Start exporting - returns false if an export is already running or
+    // the file can't be created
+    bool start(ListModel& model, const wxString& path, ExportFormat format,
+        wxEvtHandler* notify, ProgressCallback onProgress, DoneCallback onDone) {
+
+        if (running) {
+            return false;
+        }
+
+        join();
+
+        std::FILE* file = wxFopen(path, "wb");
+
+        if (!file) {
+            return false;
+        }
+
+        cancelled = false;
+        running = true;
+        model.backgroundReaders++;
+
+        worker = std::thread([this, &model, file, format, notify, onProgress, onDone, view = model.viewRows()]() {
+
+            bool ok = write(model, view, file, format, notify, onProgress);
+            ok = (std::fclose(file) == 0) && ok;
+
+            model.backgroundReaders--;
+            running = false;
+
+            wxString message = cancelled ? wxString("Export cancelled")
+                : ok ? wxString::Format("Exported %zu rows", view.size())
+                : wxString("Export failed - could not write file");
+
+            notify->CallAfter([onDone, ok, message]() {
+                onDone(ok, message);
+                });
+            });
+
+        return true;
+    }
+
+    // Stop a running export (waits for the worker to finish)
+    void cancel() {
+
+        cancelled = true;
+        join();
+    }
+
+private:
+
+    std::thread worker;
+    std::atomic<bool> running{ false };
+    std::atomic<bool> cancelled{ false };
+
+    void join() {
+
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    bool write(const ListModel& model, const std::vector<size_t>& view, std::FILE* file,
+        ExportFormat format, wxEvtHandler* notify, const ProgressCallback& onProgress) {
+
+        std::string buffer;
+        buffer.reserve(BufferSize + 64 * 1024);
+
+        if (format == ExportFormat::Binary) {
+
+            ExportFileHeader header;
+            header.rowCount = view.size();
+            buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+
+        RowCursor rows(model);
+
+        const size_t total = view.size();
+        const size_t progressStep = std::max<size_t>(total / 100, 64 * 1024);
+        size_t nextProgress = progressStep;
+
+        for (size_t i = 0; i < total; i++) {
+
+            const ItemData& item = rows[view[i]];
+
+            if (format == ExportFormat::CSV) {
+                RowFormat::csv(buffer, item);
+            }
+            else {
+                RowFormat::binary(buffer, item);
+            }
+
+            if (buffer.size() >= BufferSize) {
+
+                if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+                    return false;
+                }
+
+                buffer.clear(); // keeps capacity
+            }
+
+            if (i + 1 == nextProgress) {
+
+                if (cancelled) {
+                    return false;
+                }
+
+                nextProgress += progressStep;
+
+                notify->CallAfter([onProgress, done = i + 1, total]() {
+                    onProgress(done, total);
+                    });
+            }
+        }
+
+        return std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    }
+};
@@ -0,0 +1,535 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <wx/filename.h>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "listmodel.h"
+#include "exporter.h"
+#include "permutationfile.h"
+
+
+// Sorts a file backed (RowSource) model on one of its columns without
+// loading it: the rows are read in order a block at a time, (key, row)
+// records are sorted in memory a budget's worth at a time and written out
+// as sorted runs, then the runs are k-way merged (in several passes if
+// there are many) into a permutation file.  All file I/O is large and
+// sequential.  Runs on a worker thread; callbacks are delivered on the UI
+// thread via notify->CallAfter.
+//
+// Keys are compared as bytes - ids big endian with the sign bit flipped,
+// text in whatever encoding makes byte order wxString's order: UTF-16
+// code units big endian on Windows (wxString compares UTF-16 units there,
+// so supplementary characters sort before U+E000-U+FFFF), UTF-8 (code
+// point order) elsewhere.  So the disk order agrees with rowLess, which
+// places rows later inserted into it.  Equal keys keep model order, as
+// the in-memory stable sort does.
+class ExternalSorter {
+
+public:
+
+    using ProgressCallback = std::function<void(const wxString& status)>;
+    using DoneCallback = std::function<void(std::shared_ptr<MappedPermutation> order, const wxString& message)>;
+
+    // Models with fewer rows than this are sorted in memory instead
+    static constexpr size_t MinRows = 1000 * 1000;
+
+    // Memory for one run (keys + entries), I/O buffer size, runs per merge
+    static constexpr size_t RunBudget = 256 * 1024 * 1024;
+    static constexpr size_t IoBufferSize = 4 * 1024 * 1024;
+    static constexpr size_t MaxFanIn = 64;
+
+    ~ExternalSorter() {
+
+        cancel();
+    }
+
+    bool isRunning() const { return running; }
+
+    bool start(ListModel& model, int column, wxEvtHandler* notify, ProgressCallback onProgress, DoneCallback onDone) {
+
+        if (running || !model.source) {
+            return false;
+        }
+
+        join();
+
+        cancelled = false;
+        running = true;
+        model.backgroundReaders++;
+
+        // the order is of these rows - dropped if they change before it's shown
+        uint64_t dataVersion = model.dataVersion;
+        size_t rows = model.totalRows();
+
+        worker = std::thread([this, &model, source = model.source, column, notify, onProgress, onDone, dataVersion, rows]() {
+
+            wxString error;
+            wxString path = sort(*source, column, notify, onProgress, error);
+
+            running = false;
+
+            std::shared_ptr<MappedPermutation> order;
+
+            if (!path.IsEmpty()) {
+
+                order = MappedPermutation::open(path, true, error);
+
+                if (!order) {
+                    wxRemoveFile(path);
+                }
+            }
+
+            wxString message = cancelled ? wxString("Sort cancelled")
+                : order ? wxString::Format("Sorted %zu rows on disk", order->size())
+                : "Sort failed - " + error;
+
+            // the rows stay registered as read until the UI thread has the
+            // result, so a drain or reload can't change them in between
+            notify->CallAfter([&model, onDone, order, message, dataVersion, rows]() mutable {
+
+                model.backgroundReaders--;
+
+                if (order && (model.dataVersion != dataVersion || model.totalRows() != rows || order->size() != rows)) {
+                    order.reset();
+                    message = "Sort discarded - the rows changed while sorting";
+                }
+
+                onDone(order, message);
+                });
+            });
+
+        return true;
+    }
+
+    // Stop a running sort (waits for the worker to finish)
+    void cancel() {
+
+        cancelled = true;
+        join();
+    }
+
+private:
+
+    std::thread worker;
+    std::atomic<bool> running{ false };
+    std::atomic<bool> cancelled{ false };
+
+    void join() {
+
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    // Sequential writer with a large buffer
+    class RunWriter {
+
+    public:
+
+        explicit RunWriter(const wxString& path) : file(wxFopen(path, "wb")) {
+
+            buffer.reserve(IoBufferSize);
+        }
+
+        ~RunWriter() {
+
+            if (file) {
+                std::fclose(file);
+            }
+        }
+
+        bool isOpen() const { return file != nullptr; }
+
+        void write(const void* data, size_t size) {
+
+            buffer.append(static_cast<const char*>(data), size);
+
+            if (buffer.size() >= IoBufferSize) {
+                flush();
+            }
+        }
+
+        void record(uint64_t row, const char* key, uint32_t length) {
+
+            write(&row, sizeof(row));
+            write(&length, sizeof(length));
+            write(key, length);
+        }
+
+        // false if anything failed to write
+        bool close() {
+
+            flush();
+
+            bool closed = std::fclose(file) == 0;
+            file = nullptr;
+
+            return closed && ok;
+        }
+
+    private:
+
+        std::FILE* file;
+        std::string buffer;
+        bool ok{ true };
+
+        void flush() {
+
+            ok = ok && std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+            buffer.clear();
+        }
+    };
+
+    // Sequential reader of a run's (row, key) records
+    class RunReader {
+
+    public:
+
+        RunReader(const wxString& path, size_t bufferSize) : file(wxFopen(path, "rb")), capacity(bufferSize) {}
+
+        ~RunReader() {
+
+            if (file) {
+                std::fclose(file);
+            }
+        }
+
+        uint64_t row{ 0 };
+        std::string key;
+
+        // Read the next record - false at the end (or on error)
+        bool next() {
+
+            uint32_t length;
+
+            if (!read(&row, sizeof(row)) || !read(&length, sizeof(length))) {
+                return false;
+            }
+
+            key.resize(length);
+            return read(key.data(), length);
+        }
+
+    private:
+
+        std::FILE* file;
+        size_t capacity;
+        std::string buffer;
+        size_t at{ 0 };
+
+        bool read(void* data, size_t size) {
+
+            char* out = static_cast<char*>(data);
+
+            while (size > 0) {
+
+                if (at == buffer.size()) {
+
+                    if (!file) {
+                        return false;
+                    }
+
+                    buffer.resize(capacity);
+                    buffer.resize(std::fread(buffer.data(), 1, capacity, file));
+                    at = 0;
+
+                    if (buffer.empty()) {
+                        return false;
+                    }
+                }
+
+                size_t n = std::min(size, buffer.size() - at);
+                std::memcpy(out, buffer.data() + at, n);
+
+                at += n;
+                out += n;
+                size -= n;
+            }
+
+            return true;
+        }
+    };
+
+    static bool keyLess(const char* k1, size_t n1, uint64_t r1, const char* k2, size_t n2, uint64_t r2) {
+
+        int c = std::memcmp(k1, k2, std::min(n1, n2));
+
+        if (c != 0) {
+            return c < 0;
+        }
+
+        return (n1 != n2) ? n1 < n2 : r1 < r2;
+    }
+
+    static void appendKey(std::string& out, const ItemData& item, int column) {
+
+        switch (column) {
+        case 0: {
+            uint32_t key = static_cast<uint32_t>(item.id) ^ 0x80000000u;
+            char bytes[4] = { char(key >> 24), char(key >> 16), char(key >> 8), char(key) };
+            out.append(bytes, sizeof(bytes));
+            break;
+        }
+        case 1: appendText(out, item.name); break;
+        default: appendText(out, item.description); break;
+        }
+    }
+
+    static void appendText(std::string& out, const wxString& text) {
+
+#ifdef __WXMSW__
+        const wchar_t* units = text.wc_str();
+
+        for (size_t i = 0; i < text.length(); i++) {
+
+            uint16_t unit = static_cast<uint16_t>(units[i]);
+            out.push_back(static_cast<char>(unit >> 8));
+            out.push_back(static_cast<char>(unit & 0xFF));
+        }
+#else
+        appendUtf8(out, text);
+#endif
+    }
+
+    static wxString tempPath() {
+
+        return wxFileName::CreateTempFileName(wxFileName::GetTempDir() + wxFileName::GetPathSeparator() + "wxlsort");
+    }
+
+    static void removeAll(const std::vector<wxString>& paths) {
+
+        for (auto& path : paths) {
+            wxRemoveFile(path);
+        }
+    }
+
+    // Returns the permutation file path, or empty on failure/cancel
+    wxString sort(const RowSource& source, int column, wxEvtHandler* notify, const ProgressCallback& onProgress, wxString& error) {
+
+        auto progress = [&](const wxString& status) {
+            notify->CallAfter([onProgress, status]() { onProgress(status); });
+            };
+
+        std::vector<wxString> runs;
+
+        if (!writeRuns(source, column, runs, progress, error)) {
+            removeAll(runs);
+            return wxString();
+        }
+
+        // Merge passes until one merge can take every run
+        while (runs.size() > MaxFanIn) {
+
+            progress(wxString::Format("Merging %zu runs...", runs.size()));
+
+            std::vector<wxString> merged;
+
+            for (size_t first = 0; first < runs.size(); first += MaxFanIn) {
+
+                std::vector<wxString> group(runs.begin() + first, runs.begin() + std::min(runs.size(), first + MaxFanIn));
+                wxString path = tempPath();
+
+                merged.push_back(path);
+
+                if (!merge(group, path, false, 0, error)) {
+                    removeAll(runs);
+                    removeAll(merged);
+                    return wxString();
+                }
+
+                removeAll(group);
+            }
+
+            runs = merged;
+        }
+
+        progress(wxString::Format("Merging %zu runs...", runs.size()));
+
+        wxString path = tempPath();
+        bool ok = merge(runs, path, true, source.rowCount(), error);
+
+        removeAll(runs);
+
+        if (!ok) {
+            wxRemoveFile(path);
+            return wxString();
+        }
+
+        return path;
+    }
+
+    // Read all rows in order, writing a sorted run per RunBudget of records
+    bool writeRuns(const RowSource& source, int column, std::vector<wxString>& runs,
+        const std::function<void(const wxString&)>& progress, wxString& error) {
+
+        struct Entry {
+
+            uint64_t    row;
+            size_t      offset;
+            uint32_t    length;
+        };
+
+        std::string keys;
+        std::vector<Entry> entries;
+        std::vector<ItemData> rows;
+
+        auto flushRun = [&]() {
+
+            std::sort(entries.begin(), entries.end(), [&keys](const Entry& a, const Entry& b) {
+                return keyLess(keys.data() + a.offset, a.length, a.row, keys.data() + b.offset, b.length, b.row);
+                });
+
+            wxString path = tempPath();
+            runs.push_back(path);
+
+            RunWriter out(path);
+
+            if (!out.isOpen()) {
+                error = wxString::Format("Could not create %s", path);
+                return false;
+            }
+
+            for (auto& entry : entries) {
+                out.record(entry.row, keys.data() + entry.offset, entry.length);
+            }
+
+            keys.clear();
+            entries.clear();
+
+            if (!out.close()) {
+                error = "Could not write a sort run (disk full?)";
+                return false;
+            }
+
+            return true;
+        };
+
+        size_t blocks = source.blockCount();
+        size_t progressStep = std::max<size_t>(blocks / 100, 1);
+
+        for (size_t block = 0; block < blocks; block++) {
+
+            if (cancelled) {
+                return false;
+            }
+
+            // keep the next few blocks' reads in flight
+            if (block + 1 < blocks) {
+                source.willNeed(block + 1, std::min(block + 8, blocks - 1));
+            }
+
+            source.decodeBlock(block, rows);
+
+            uint64_t firstRow = static_cast<uint64_t>(block) * RowSource::BlockRows;
+
+            for (size_t i = 0; i < rows.size(); i++) {
+
+                size_t offset = keys.size();
+                appendKey(keys, rows[i], column);
+                entries.push_back({ firstRow + i, offset, static_cast<uint32_t>(keys.size() - offset) });
+            }
+
+            if (keys.size() + entries.size() * sizeof(Entry) >= RunBudget && !flushRun()) {
+                return false;
+            }
+
+            if (block % progressStep == 0) {
+                progress(wxString::Format("Sorting... %zu / %zu rows read", firstRow + rows.size(), source.rowCount()));
+            }
+        }
+
+        return entries.empty() || flushRun();
+    }
+
+    // k-way merge of runs - into another run, or (final) into the
+    // permutation file keeping only the rows
+    bool merge(const std::vector<wxString>& inputs, const wxString& path, bool final, size_t rowCount, wxString& error) {
+
+        size_t bufferSize = std::max<size_t>(64 * 1024, std::min(IoBufferSize, RunBudget / std::max<size_t>(inputs.size(), 1)));
+
+        std::vector<std::unique_ptr<RunReader>> readers;
+
+        for (auto& input : inputs) {
+            readers.push_back(std::make_unique<RunReader>(input, bufferSize));
+        }
+
+        RunWriter out(path);
+
+        if (!out.isOpen()) {
+            error = wxString::Format("Could not create %s", path);
+            return false;
+        }
+
+        if (final) {
+
+            PermutationFileHeader header;
+            header.rowCount = rowCount;
+            out.write(&header, sizeof(header));
+        }
+
+        // min-heap of readers on their current record
+        auto greater = [&readers](size_t a, size_t b) {
+
+            const RunReader& ra = *readers[a];
+            const RunReader& rb = *readers[b];
+            return keyLess(rb.key.data(), rb.key.size(), rb.row, ra.key.data(), ra.key.size(), ra.row);
+            };
+
+        std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+
+        for (size_t i = 0; i < readers.size(); i++) {
+            if (readers[i]->next()) {
+                heap.push(i);
+            }
+        }
+
+        size_t written = 0;
+
+        while (!heap.empty()) {
+
+            size_t i = heap.top();
+            heap.pop();
+
+            RunReader& reader = *readers[i];
+
+            if (final) {
+                out.write(&reader.row, sizeof(reader.row));
+            }
+            else {
+                out.record(reader.row, reader.key.data(), static_cast<uint32_t>(reader.key.size()));
+            }
+
+            written++;
+
+            if ((written & 0xFFFF) == 0 && cancelled) {
+                return false;
+            }
+
+            if (reader.next()) {
+                heap.push(i);
+            }
+        }
+
+        if (!out.close()) {
+            error = "Could not write the sort order (disk full?)";
+            return false;
+        }
+
+        if (final && written != rowCount) {
+            error = "Sort runs were incomplete";
+            return false;
+        }
+
+        return true;
+    }
+};
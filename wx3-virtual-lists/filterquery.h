@@ -0,0 +1,672 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "listmodel.h"
+#include "workerpool.h"
+
+
+// Selection bitmap over model rows - bit r set = row r selected
+struct RowBitmap {
+
+    std::vector<uint64_t> words;
+    size_t rows{ 0 };
+
+    explicit RowBitmap(size_t rowCount = 0) : words((rowCount + 63) / 64, 0), rows(rowCount) {}
+
+    bool test(size_t row) const { return (words[row / 64] >> (row % 64)) & 1; }
+};
+
+
+// Ids of rows [firstRow, firstRow + count) - a slice of the model's id
+// column, or one chunk's ids read through a row cursor
+struct IdSlice {
+
+    const int32_t*  ids;        // ids[0] is row firstRow's
+    size_t          firstRow;
+    size_t          count;
+};
+
+
+// Compiled predicate.  Works a range of 64-row words at a time: mask says
+// which rows still need an answer (rows outside it come out as 0), so
+// "a and b" only runs b on the rows a kept, and "a or b" only on the rows
+// a didn't.  Id comparisons scan the model's id column 64 rows to a word
+// (vectorizes); text tests only visit set mask bits.
+class QueryNode {
+
+public:
+
+    virtual ~QueryNode() = default;
+
+    // Evaluate words [0, wordCount) of the range starting at firstRow
+    // (a multiple of 64) into out (which must not be mask)
+    virtual void eval(RowCursor& rows, const IdSlice& ids, size_t firstRow, size_t wordCount,
+        const uint64_t* mask, uint64_t* out) const = 0;
+
+    // Single row
+    virtual bool matches(const ItemData& item) const = 0;
+};
+
+
+namespace Query {
+
+    using Node = std::unique_ptr<QueryNode>;
+
+    inline int popcount(uint64_t v) {
+
+#if defined(_MSC_VER)
+        return static_cast<int>(__popcnt64(v));
+#else
+        return __builtin_popcountll(v);
+#endif
+    }
+
+    // Index of the lowest set bit (v != 0)
+    inline int ctz(uint64_t v) {
+
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, v);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(v);
+#endif
+    }
+
+    enum class Op { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual, Contains, StartsWith, EndsWith, Matches };
+
+    class IdCompare : public QueryNode {
+
+    public:
+
+        IdCompare(Op op, int64_t value) : op(op), value(value) {}
+
+        void eval(RowCursor& rows, const IdSlice& ids, size_t firstRow, size_t wordCount,
+            const uint64_t* mask, uint64_t* out) const override {
+
+            switch (op) {
+            case Op::Equal: scan(ids, firstRow, wordCount, mask, out, [v = value](int64_t id) { return id == v; }); break;
+            case Op::NotEqual: scan(ids, firstRow, wordCount, mask, out, [v = value](int64_t id) { return id != v; }); break;
+            case Op::Less: scan(ids, firstRow, wordCount, mask, out, [v = value](int64_t id) { return id < v; }); break;
+            case Op::LessEqual: scan(ids, firstRow, wordCount, mask, out, [v = value](int64_t id) { return id <= v; }); break;
+            case Op::Greater: scan(ids, firstRow, wordCount, mask, out, [v = value](int64_t id) { return id > v; }); break;
+            default: scan(ids, firstRow, wordCount, mask, out, [v = value](int64_t id) { return id >= v; }); break;
+            }
+        }
+
+        bool matches(const ItemData& item) const override {
+
+            switch (op) {
+            case Op::Equal: return item.id == value;
+            case Op::NotEqual: return item.id != value;
+            case Op::Less: return item.id < value;
+            case Op::LessEqual: return item.id <= value;
+            case Op::Greater: return item.id > value;
+            default: return item.id >= value;
+            }
+        }
+
+    private:
+
+        Op op;
+        int64_t value;
+
+        // One comparison per row, packed 64 to a word - the inner loop
+        // has no branches so the compiler can vectorize it
+        template<typename Test>
+        static void scan(const IdSlice& ids, size_t firstRow, size_t wordCount,
+            const uint64_t* mask, uint64_t* out, Test test) {
+
+            // relative to firstRow from here on
+            const int32_t* column = ids.ids + (firstRow - ids.firstRow);
+            size_t total = ids.firstRow + ids.count - firstRow;
+
+            for (size_t w = 0; w < wordCount; w++) {
+
+                size_t base = w * 64;
+
+                if (mask[w] == 0) {
+                    out[w] = 0;
+                    continue;
+                }
+
+                uint64_t bits = 0;
+
+                if (base + 64 <= total) {
+                    for (size_t j = 0; j < 64; j++) {
+                        bits |= static_cast<uint64_t>(test(column[base + j])) << j;
+                    }
+                }
+                else {
+                    for (size_t j = 0; base + j < total; j++) {
+                        bits |= static_cast<uint64_t>(test(column[base + j])) << j;
+                    }
+                }
+
+                out[w] = bits & mask[w];
+            }
+        }
+    };
+
+    class TextTest : public QueryNode {
+
+    public:
+
+        TextTest(int column, Op op, const wxString& value) : column(column), op(op), value(value) {}
+
+        void eval(RowCursor& rows, const IdSlice& ids, size_t firstRow, size_t wordCount,
+            const uint64_t* mask, uint64_t* out) const override {
+
+            for (size_t w = 0; w < wordCount; w++) {
+
+                uint64_t pending = mask[w];
+                uint64_t bits = 0;
+
+                while (pending) {
+
+                    int j = ctz(pending);
+                    pending &= pending - 1;
+
+                    if (matches(rows[firstRow + w * 64 + j])) {
+                        bits |= uint64_t{ 1 } << j;
+                    }
+                }
+
+                out[w] = bits;
+            }
+        }
+
+        bool matches(const ItemData& item) const override {
+
+            const wxString& text = (column == 1) ? item.name : item.description;
+
+            switch (op) {
+            case Op::Equal: return text == value;
+            case Op::NotEqual: return text != value;
+            case Op::Less: return text < value;
+            case Op::LessEqual: return text <= value;
+            case Op::Greater: return text > value;
+            case Op::GreaterEqual: return text >= value;
+            case Op::Contains: return text.Contains(value);
+            case Op::StartsWith: return text.StartsWith(value);
+            case Op::EndsWith: return text.EndsWith(value);
+            default: return text.Matches(value);
+            }
+        }
+
+    private:
+
+        int column;
+        Op op;
+        wxString value;
+    };
+
+    class And : public QueryNode {
+
+    public:
+
+        And(Node left, Node right) : left(std::move(left)), right(std::move(right)) {}
+
+        void eval(RowCursor& rows, const IdSlice& ids, size_t firstRow, size_t wordCount,
+            const uint64_t* mask, uint64_t* out) const override {
+
+            std::vector<uint64_t> kept(wordCount);
+
+            left->eval(rows, ids, firstRow, wordCount, mask, kept.data());
+            right->eval(rows, ids, firstRow, wordCount, kept.data(), out);
+        }
+
+        bool matches(const ItemData& item) const override { return left->matches(item) && right->matches(item); }
+
+    private:
+
+        Node left;
+        Node right;
+    };
+
+    class Or : public QueryNode {
+
+    public:
+
+        Or(Node left, Node right) : left(std::move(left)), right(std::move(right)) {}
+
+        void eval(RowCursor& rows, const IdSlice& ids, size_t firstRow, size_t wordCount,
+            const uint64_t* mask, uint64_t* out) const override {
+
+            std::vector<uint64_t> rest(wordCount);
+            std::vector<uint64_t> more(wordCount);
+
+            left->eval(rows, ids, firstRow, wordCount, mask, out);
+
+            for (size_t w = 0; w < wordCount; w++) {
+                rest[w] = mask[w] & ~out[w];
+            }
+
+            right->eval(rows, ids, firstRow, wordCount, rest.data(), more.data());
+
+            for (size_t w = 0; w < wordCount; w++) {
+                out[w] |= more[w];
+            }
+        }
+
+        bool matches(const ItemData& item) const override { return left->matches(item) || right->matches(item); }
+
+    private:
+
+        Node left;
+        Node right;
+    };
+
+    class Not : public QueryNode {
+
+    public:
+
+        explicit Not(Node child) : child(std::move(child)) {}
+
+        void eval(RowCursor& rows, const IdSlice& ids, size_t firstRow, size_t wordCount,
+            const uint64_t* mask, uint64_t* out) const override {
+
+            child->eval(rows, ids, firstRow, wordCount, mask, out);
+
+            for (size_t w = 0; w < wordCount; w++) {
+                out[w] = mask[w] & ~out[w];
+            }
+        }
+
+        bool matches(const ItemData& item) const override { return !child->matches(item); }
+
+    private:
+
+        Node child;
+    };
+
+
+    // Recursive descent over
+    //   query      := and ("or" and)*
+    //   and        := unary ("and" unary)*
+    //   unary      := "not" unary | "(" query ")" | comparison
+    //   comparison := field op value
+    // fields id, name, description; ops = != < <= > >= and, for text,
+    // contains, startswith, endswith, matches (wildcards * and ?)
+    class Parser {
+
+    public:
+
+        Parser(const wxString& text, wxString& error) : text(text), error(error) {}
+
+        Node parse() {
+
+            Node node = orExpression();
+
+            skipSpace();
+
+            if (node && at < text.length()) {
+                return fail(wxString::Format("Unexpected '%s'", text.Mid(at)));
+            }
+
+            return node;
+        }
+
+    private:
+
+        const wxString& text;
+        wxString& error;
+        size_t at{ 0 };
+
+        Node fail(const wxString& message) {
+
+            if (error.IsEmpty()) {
+                error = message;
+            }
+
+            return nullptr;
+        }
+
+        void skipSpace() {
+
+            while (at < text.length() && wxIsspace(text[at])) {
+                at++;
+            }
+        }
+
+        // Next word (letters), lower case, without consuming it
+        wxString peekWord() {
+
+            skipSpace();
+
+            size_t end = at;
+
+            while (end < text.length() && wxIsalpha(text[end])) {
+                end++;
+            }
+
+            return text.Mid(at, end - at).Lower();
+        }
+
+        bool acceptWord(const wxString& word) {
+
+            if (peekWord() != word) {
+                return false;
+            }
+
+            at += word.length();
+            return true;
+        }
+
+        bool accept(const wxString& symbol) {
+
+            skipSpace();
+
+            if (text.Mid(at, symbol.length()) == symbol) {
+                at += symbol.length();
+                return true;
+            }
+
+            return false;
+        }
+
+        Node orExpression() {
+
+            Node left = andExpression();
+
+            while (left && acceptWord("or")) {
+
+                Node right = andExpression();
+
+                if (!right) {
+                    return nullptr;
+                }
+
+                left = std::make_unique<Or>(std::move(left), std::move(right));
+            }
+
+            return left;
+        }
+
+        Node andExpression() {
+
+            Node left = unary();
+
+            while (left && acceptWord("and")) {
+
+                Node right = unary();
+
+                if (!right) {
+                    return nullptr;
+                }
+
+                left = std::make_unique<And>(std::move(left), std::move(right));
+            }
+
+            return left;
+        }
+
+        Node unary() {
+
+            if (acceptWord("not")) {
+
+                Node child = unary();
+                return child ? std::make_unique<Not>(std::move(child)) : nullptr;
+            }
+
+            if (accept("(")) {
+
+                Node node = orExpression();
+
+                if (node && !accept(")")) {
+                    return fail("Missing ')'");
+                }
+
+                return node;
+            }
+
+            return comparison();
+        }
+
+        Node comparison() {
+
+            wxString field = peekWord();
+            int column = (field == "id") ? 0 : (field == "name") ? 1 : (field == "description") ? 2 : -1;
+
+            if (column < 0) {
+                return fail(field.IsEmpty() ? wxString("Expected id, name or description") : wxString::Format("Unknown field '%s'", field));
+            }
+
+            at += field.length();
+
+            Op op;
+
+            // longest symbols first
+            if (accept("!=")) op = Op::NotEqual;
+            else if (accept("==") || accept("=")) op = Op::Equal;
+            else if (accept("<=")) op = Op::LessEqual;
+            else if (accept(">=")) op = Op::GreaterEqual;
+            else if (accept("<")) op = Op::Less;
+            else if (accept(">")) op = Op::Greater;
+            else if (acceptWord("contains")) op = Op::Contains;
+            else if (acceptWord("startswith")) op = Op::StartsWith;
+            else if (acceptWord("endswith")) op = Op::EndsWith;
+            else if (acceptWord("matches")) op = Op::Matches;
+            else return fail(wxString::Format("Expected an operator after '%s'", field));
+
+            skipSpace();
+
+            if (column == 0) {
+
+                if (op >= Op::Contains) {
+                    return fail("id can only be compared (= != < <= > >=)");
+                }
+
+                size_t start = at;
+
+                if (at < text.length() && text[at] == '-') {
+                    at++;
+                }
+
+                while (at < text.length() && wxIsdigit(text[at])) {
+                    at++;
+                }
+
+                wxLongLong_t value;
+
+                if (!text.Mid(start, at - start).ToLongLong(&value)) {
+                    return fail("Expected a number after id");
+                }
+
+                return std::make_unique<IdCompare>(op, value);
+            }
+
+            if (!accept("\"")) {
+                return fail(wxString::Format("Expected a \"quoted\" value after %s", field));
+            }
+
+            wxString value;
+
+            while (at < text.length() && text[at] != '"') {
+                value += text[at++];
+            }
+
+            if (!accept("\"")) {
+                return fail("Missing closing '\"'");
+            }
+
+            return std::make_unique<TextTest>(column, op, value);
+        }
+    };
+}
+
+
+// A parsed query, e.g. id > 100 and name startswith "C-".  select() runs
+// it over every model row on all cores (the shared WorkerPool; a small
+// model on the calling thread): the rows are cut into chunks, each thread
+// evaluates the predicate tree into its chunks of a shared selection
+// bitmap, then the bitmap is turned into the row permutation (counts per
+// chunk, prefix sum, parallel fill).
+class FilterQuery : public RowFilter {
+
+public:
+
+    // Rows per work item (a multiple of 64)
+    static constexpr size_t ChunkRows = 64 * 1024;
+
+    // Fewer chunks than this run on the calling thread - waking the pool
+    // costs more than it saves
+    static constexpr size_t ParallelChunks = 4;
+
+    // nullptr (and error set) if the query doesn't parse
+    static std::shared_ptr<FilterQuery> compile(const wxString& query, wxString& error) {
+
+        Query::Node root = Query::Parser(query, error).parse();
+
+        if (!root) {
+            return nullptr;
+        }
+
+        return std::shared_ptr<FilterQuery>(new FilterQuery(query, std::move(root)));
+    }
+
+    const wxString& text() const { return source; }
+
+    // Selection bitmap of every row passing the query
+    RowBitmap evaluate(const ListModel& model) const {
+
+        const std::vector<int32_t>& ids = model.idColumn();
+        size_t total = model.totalRows();
+
+        RowBitmap bitmap(total);
+        size_t chunks = (total + ChunkRows - 1) / ChunkRows;
+
+        parallel(chunks, [&](RowCursor& rows, size_t chunk) {
+
+            size_t firstRow = chunk * ChunkRows;
+            evaluateRange(rows, &ids, firstRow, std::min(total, firstRow + ChunkRows) - firstRow, bitmap.words.data() + firstRow / 64);
+            }, model);
+
+        return bitmap;
+    }
+
+    // Evaluate rows [firstRow, firstRow + count) into words - bit j of
+    // words[w] is row firstRow + 64w + j.  firstRow must be a multiple of
+    // 64.  ids is model.idColumn() (built on the UI thread), or nullptr to
+    // read the range's ids through rows - so a background scan of a file
+    // never has to decode the whole file up front.
+    void evaluateRange(RowCursor& rows, const std::vector<int32_t>* ids, size_t firstRow, size_t count, uint64_t* words) const {
+
+        thread_local std::vector<int32_t> chunkIds;
+
+        IdSlice slice;
+
+        if (ids) {
+            slice = { ids->data(), 0, ids->size() };
+        }
+        else {
+
+            chunkIds.resize(count);
+
+            for (size_t i = 0; i < count; i++) {
+                chunkIds[i] = rows[firstRow + i].id;
+            }
+
+            slice = { chunkIds.data(), firstRow, count };
+        }
+
+        size_t wordCount = (count + 63) / 64;
+
+        std::vector<uint64_t> mask(wordCount, ~uint64_t{ 0 });
+
+        // no rows past the end
+        if (count % 64 != 0) {
+            mask.back() = (uint64_t{ 1 } << (count % 64)) - 1;
+        }
+
+        root->eval(rows, slice, firstRow, wordCount, mask.data(), words);
+    }
+
+    void select(const ListModel& model, std::vector<size_t>& rows) const override {
+
+        RowBitmap bitmap = evaluate(model);
+        size_t chunks = (bitmap.rows + ChunkRows - 1) / ChunkRows;
+        size_t chunkWords = ChunkRows / 64;
+
+        // matches per chunk, then where each chunk's rows go
+        std::vector<size_t> offsets(chunks + 1, 0);
+
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+
+            size_t count = 0;
+            size_t end = std::min(bitmap.words.size(), (chunk + 1) * chunkWords);
+
+            for (size_t w = chunk * chunkWords; w < end; w++) {
+                count += Query::popcount(bitmap.words[w]);
+            }
+
+            offsets[chunk + 1] = offsets[chunk] + count;
+        }
+
+        rows.resize(offsets[chunks]);
+
+        parallel(chunks, [&](RowCursor&, size_t chunk) {
+
+            size_t out = offsets[chunk];
+            size_t end = std::min(bitmap.words.size(), (chunk + 1) * chunkWords);
+
+            for (size_t w = chunk * chunkWords; w < end; w++) {
+
+                for (uint64_t bits = bitmap.words[w]; bits; bits &= bits - 1) {
+                    rows[out++] = w * 64 + Query::ctz(bits);
+                }
+            }
+            }, model);
+    }
+
+    bool matches(const ListModel& model, const ItemData& item) const override {
+
+        return root->matches(item);
+    }
+
+private:
+
+    wxString source;
+    Query::Node root;
+
+    FilterQuery(const wxString& query, Query::Node root) : source(query), root(std::move(root)) {}
+
+    // Run work(rows, chunk) for every chunk on all cores - each thread
+    // has its own row cursor.  The rows are registered as being read
+    // (backgroundReaders) until every thread is done with them.
+    template<typename Work>
+    static void parallel(size_t chunks, Work work, const ListModel& model) {
+
+        std::atomic<size_t> next{ 0 };
+
+        auto run = [&]() {
+
+            RowCursor rows(model);
+
+            for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+                work(rows, chunk);
+            }
+            };
+
+        model.backgroundReaders++;
+
+        if (chunks < ParallelChunks) {
+            run();
+        }
+        else {
+            WorkerPool::shared().run(chunks - 1, run);
+        }
+
+        model.backgroundReaders--;
+    }
+};
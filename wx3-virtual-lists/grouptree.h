@@ -0,0 +1,259 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <wx/hashmap.h>
+#include <vector>
+#include <memory>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+
+#include "listmodel.h"
+#include "computedcolumn.h"
+
+
+// Two level tree over the model's view - a header row per distinct value
+// of a key expression, followed (when expanded) by the view rows with
+// that value, in view order.
+//
+// Visible rows are never materialized.  A Fenwick tree over the groups
+// holds each group's visible height (1, or 1 + rows when expanded), so
+// mapping a list index to a group/row and expanding or collapsing a group
+// are both O(log groups) - however many rows the group has.
+class GroupTree {
+
+public:
+
+    // What a visible (list) row shows
+    struct Node {
+
+        bool    isGroup{ true };
+        size_t  group{ 0 };
+        size_t  row{ 0 };       // model row (child rows only)
+    };
+
+    // Group the current view by key.  Groups that were expanded before
+    // (matched by label) stay expanded.
+    void build(const ListModel& model, ComputedColumn& key) {
+
+        std::unordered_set<wxString, wxStringHash, wxStringEqual> wasExpanded;
+
+        for (size_t g = 0; g < groupCount(); g++) {
+            if (expanded[g]) {
+                wasExpanded.insert(labels[g]);
+            }
+        }
+
+        std::vector<size_t> view = model.viewRows();
+
+        key.prepare(model, view);
+
+        // Distinct keys - identified by the first row that has them
+        auto hash = [&key](size_t row) { return key.hash(row); };
+        auto equal = [&key](size_t r1, size_t r2) { return key.equal(r1, r2); };
+
+        std::unordered_map<size_t, size_t, decltype(hash), decltype(equal)> groupOfKey(16, hash, equal);
+        std::vector<size_t> firstRows;
+        std::vector<size_t> groupOfRow(view.size());
+
+        for (size_t i = 0; i < view.size(); i++) {
+
+            auto found = groupOfKey.emplace(view[i], firstRows.size());
+
+            if (found.second) {
+                firstRows.push_back(view[i]);
+            }
+
+            groupOfRow[i] = found.first->second;
+        }
+
+        // Groups in key order
+        std::vector<size_t> order(firstRows.size());
+        std::iota(order.begin(), order.end(), size_t{ 0 });
+        std::sort(order.begin(), order.end(), [&](size_t g1, size_t g2) { return key.less(firstRows[g1], firstRows[g2]); });
+
+        std::vector<size_t> position(order.size());
+
+        for (size_t g = 0; g < order.size(); g++) {
+            position[order[g]] = g;
+        }
+
+        // Counting sort of the view rows into their groups (stable, so each
+        // group keeps view order)
+        size_t groups = order.size();
+
+        groupStart.assign(groups + 1, 0);
+
+        for (size_t g : groupOfRow) {
+            groupStart[position[g] + 1]++;
+        }
+
+        std::partial_sum(groupStart.begin(), groupStart.end(), groupStart.begin());
+
+        rows.resize(view.size());
+        std::vector<size_t> next(groupStart.begin(), groupStart.end() - 1);
+
+        for (size_t i = 0; i < view.size(); i++) {
+            rows[next[position[groupOfRow[i]]]++] = view[i];
+        }
+
+        labels.resize(groups);
+        expanded.assign(groups, 0);
+
+        for (size_t g = 0; g < groups; g++) {
+
+            labels[g] = key.textAt(firstRows[order[g]]);
+            expanded[g] = wasExpanded.count(labels[g]) != 0;
+        }
+
+        rebuildHeights();
+
+        builtVersion = model.version;
+    }
+
+    // Model version the tree was built from
+    uint64_t version() const { return builtVersion; }
+
+    size_t groupCount() const { return labels.size(); }
+    size_t groupSize(size_t group) const { return groupStart[group + 1] - groupStart[group]; }
+    const wxString& groupLabel(size_t group) const { return labels[group]; }
+    bool isExpanded(size_t group) const { return expanded[group] != 0; }
+
+    // Number of rows the list shows
+    size_t visibleCount() const { return total; }
+
+    // Group header or row at a list index - O(log groups)
+    Node at(size_t index) const {
+
+        // descend the Fenwick tree: largest group whose start <= index
+        size_t group = 0;
+        size_t remaining = index;
+
+        for (size_t step = topStep; step > 0; step >>= 1) {
+
+            if (group + step <= groupCount() && heights[group + step] <= remaining) {
+                group += step;
+                remaining -= heights[group];
+            }
+        }
+
+        Node node;
+        node.group = group;
+        node.isGroup = (remaining == 0);
+
+        if (!node.isGroup) {
+            node.row = rows[groupStart[group] + remaining - 1];
+        }
+
+        return node;
+    }
+
+    // List index of a group's header row - O(log groups)
+    size_t headerIndex(size_t group) const {
+
+        size_t sum = 0;
+
+        for (size_t i = group; i > 0; i -= i & (~i + 1)) {
+            sum += heights[i];
+        }
+
+        return sum;
+    }
+
+    size_t memoryBytes() const {
+
+        size_t bytes = MemoryUsage::vectorBytes(labels) + MemoryUsage::vectorBytes(expanded);
+
+        for (auto& label : labels) {
+            bytes += MemoryUsage::stringHeapBytes(label);
+        }
+
+        return bytes + MemoryUsage::vectorBytes(rows) + MemoryUsage::vectorBytes(groupStart) + MemoryUsage::vectorBytes(heights);
+    }
+
+    // Append a group's model rows to out
+    void appendRows(size_t group, std::vector<size_t>& out) const {
+
+        out.insert(out.end(), rows.begin() + groupStart[group], rows.begin() + groupStart[group + 1]);
+    }
+
+    // Show or hide a group's rows - O(log groups)
+    void setExpanded(size_t group, bool expand) {
+
+        if (isExpanded(group) == expand) {
+            return;
+        }
+
+        expanded[group] = expand;
+
+        size_t size = groupSize(group);
+        add(group, expand ? size : 0 - size);
+        total = expand ? total + size : total - size;
+    }
+
+    void setAllExpanded(bool expand) {
+
+        expanded.assign(groupCount(), expand);
+        rebuildHeights();
+    }
+
+private:
+
+    std::vector<wxString> labels;
+    std::vector<uint8_t> expanded;
+
+    // rows of group g are rows[groupStart[g], groupStart[g + 1])
+    std::vector<size_t> rows;
+    std::vector<size_t> groupStart{ 0 };
+
+    // Fenwick tree (1-based) of group heights
+    std::vector<size_t> heights{ 0 };
+    size_t topStep{ 0 };
+    size_t total{ 0 };
+
+    uint64_t builtVersion{ ~uint64_t{ 0 } };
+
+    // delta may "wrap" (unsigned) to subtract
+    void add(size_t group, size_t delta) {
+
+        for (size_t i = group + 1; i <= groupCount(); i += i & (~i + 1)) {
+            heights[i] += delta;
+        }
+    }
+
+    // O(groups) construction
+    void rebuildHeights() {
+
+        size_t groups = groupCount();
+
+        heights.assign(groups + 1, 0);
+        total = 0;
+
+        for (size_t g = 0; g < groups; g++) {
+
+            size_t height = 1 + (expanded[g] ? groupSize(g) : 0);
+            size_t i = g + 1;
+
+            heights[i] += height;
+            total += height;
+
+            size_t parent = i + (i & (~i + 1));
+
+            if (parent <= groups) {
+                heights[parent] += heights[i];
+            }
+        }
+
+        topStep = 1;
+
+        while (topStep * 2 <= groups) {
+            topStep *= 2;
+        }
+
+        if (groups == 0) {
+            topStep = 0;
+        }
+    }
+};
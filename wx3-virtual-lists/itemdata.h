@@ -0,0 +1,11 @@
+#pragma once
+
+#include <wx/wx.h>
+
+
+struct ItemData {
+
+    int         id;
+    wxString    name;
+    wxString    description;
+};
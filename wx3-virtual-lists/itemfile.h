@@ -0,0 +1,169 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <vector>
+#include <memory>
+#include <cstring>
+
+#include "itemdata.h"
+#include "rowsource.h"
+#include "mappedfile.h"
+#include "exporter.h"
+
+
+// File-backed rows - a binary export (see ExportFileHeader) mapped into
+// memory.  Opening only builds an index of row offsets; rows are decoded
+// a block at a time when the list (or prefetcher) asks for them.
+class ItemFile : public RowSource {
+
+public:
+
+    // Map the file and index its rows - nullptr (and error set) on failure
+    static std::unique_ptr<ItemFile> open(const wxString& path, wxString& error) {
+
+        auto itemFile = std::unique_ptr<ItemFile>(new ItemFile());
+
+        if (!itemFile->file.open(path)) {
+            error = "Could not open " + path;
+            return nullptr;
+        }
+
+        if (!itemFile->buildIndex(error)) {
+            return nullptr;
+        }
+
+        return itemFile;
+    }
+
+    size_t rowCount() const override { return offsets.size(); }
+
+    void decodeBlock(size_t block, std::vector<ItemData>& rows) const override {
+
+        size_t first = block * BlockRows;
+        size_t last = std::min(first + BlockRows, offsets.size());
+
+        rows.clear();
+        rows.reserve(last - first);
+
+        for (size_t row = first; row < last; row++) {
+            rows.push_back(decodeRow(row));
+        }
+    }
+
+    void willNeed(size_t firstBlock, size_t lastBlock) const override {
+
+        size_t first = firstBlock * BlockRows;
+        size_t end = std::min((lastBlock + 1) * BlockRows, offsets.size());
+
+        if (first >= end) {
+            return;
+        }
+
+        size_t endOffset = (end < offsets.size()) ? offsets[end] : file.size();
+        file.willNeed(offsets[first], endOffset - offsets[first]);
+    }
+
+    void memoryUsage(MemoryUsage& usage) const override {
+
+        usage.add("Storage", "mapped file (page cache, not heap)", file.size());
+        usage.add("Index", "file row offsets", MemoryUsage::vectorBytes(offsets));
+    }
+
+    // Decode every row (for loading into memory)
+    std::vector<ItemData> readAll() const {
+
+        std::vector<ItemData> rows;
+        rows.reserve(offsets.size());
+
+        for (size_t row = 0; row < offsets.size(); row++) {
+            rows.push_back(decodeRow(row));
+        }
+
+        return rows;
+    }
+
+    ItemData decodeRow(size_t row) const {
+
+        const char* p = file.data() + offsets[row];
+
+        ItemData item;
+        std::memcpy(&item.id, p, sizeof(int32_t));
+        p += sizeof(int32_t);
+
+        item.name = readString(p);
+        item.description = readString(p);
+
+        return item;
+    }
+
+private:
+
+    MappedFile file;
+
+    // Byte offset of each row in the file
+    std::vector<uint64_t> offsets;
+
+    ItemFile() = default;
+
+    static wxString readString(const char*& p) {
+
+        uint32_t length;
+        std::memcpy(&length, p, sizeof(length));
+        p += sizeof(length);
+
+        wxString s = wxString::FromUTF8(p, length);
+        p += length;
+
+        return s;
+    }
+
+    // Walk the records once, reading only the lengths
+    bool buildIndex(wxString& error) {
+
+        ExportFileHeader header;
+        const char* base = file.data();
+        size_t size = file.size();
+
+        if (size < sizeof(header)) {
+            error = "File is too small to be a list export";
+            return false;
+        }
+
+        std::memcpy(&header, base, sizeof(header));
+
+        if (std::memcmp(header.magic, ExportFileHeader().magic, sizeof(header.magic)) != 0 || header.formatVersion != 1) {
+            error = "Not a binary list export (bad header)";
+            return false;
+        }
+
+        offsets.reserve(static_cast<size_t>(header.rowCount));
+
+        size_t at = sizeof(header);
+
+        for (uint64_t row = 0; row < header.rowCount; row++) {
+
+            offsets.push_back(at);
+            at += sizeof(int32_t);
+
+            for (int field = 0; field < 2; field++) {
+
+                uint32_t length;
+
+                if (at + sizeof(length) > size) {
+                    error = "File is truncated";
+                    return false;
+                }
+
+                std::memcpy(&length, base + at, sizeof(length));
+                at += sizeof(length) + length;
+            }
+
+            if (at > size) {
+                error = "File is truncated";
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
@@ -0,0 +1,981 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <atomic>
+#include <queue>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <chrono>
+#include <unordered_set>
+#include <unordered_map>
+
+#include "itemdata.h"
+#include "rowsource.h"
+#include "memoryusage.h"
+#include "permutationfile.h"
+#include "prefetch.h"
+
+
+class ListModel;
+
+
+// Ordering for sort columns the model doesn't hold itself (e.g. computed
+// columns) - keyed by model row
+class SortKey {
+
+public:
+
+    virtual ~SortKey() = default;
+
+    // Called before rows are compared (e.g. to compute their keys in bulk)
+    virtual void prepare(const ListModel& model, const std::vector<size_t>& rows) = 0;
+
+    virtual bool less(size_t r1, size_t r2) const = 0;
+};
+
+
+// Structured row filter (e.g. a compiled query) applied before the text
+// filter
+class RowFilter {
+
+public:
+
+    virtual ~RowFilter() = default;
+
+    // Model rows that pass, in model order
+    virtual void select(const ListModel& model, std::vector<size_t>& rows) const = 0;
+
+    // Single row test (rows added/changed after select)
+    virtual bool matches(const ListModel& model, const ItemData& item) const = 0;
+};
+
+
+// Model - rows are stored once in items, the list shows them through view
+// (a permutation of row indices built by sorting and filtering).  Sorting
+// and filtering only ever touch view, so rows never move in memory.
+//
+// Rows can instead come from a RowSource (e.g. a mapped file), decoded a
+// block at a time into a cache - always read rows through row() rather
+// than items directly.
+class ListModel {
+
+public:
+    std::vector<ItemData> items;
+
+    // Set when rows come from a RowSource rather than items
+    std::shared_ptr<RowSource> source;
+
+    // Row indices in display order (after sort + filter)
+    std::vector<size_t> view;
+
+    // Set instead of view after an on-disk sort (see ExternalSorter)
+    std::shared_ptr<MappedPermutation> sortedView;
+
+    // The on-disk order, kept while a filter shows part of it - filtered
+    // views are put in this order rather than sorted again, and clearing
+    // the filter goes back to it (see diskOrderValid)
+    std::shared_ptr<MappedPermutation> diskOrder;
+
+    // Bumped on every change to items or view so caches can spot stale data
+    uint64_t version{ 0 };
+
+    // Bumped only when row contents change (not on sort/filter) - for caches
+    // keyed by row rather than by view position
+    uint64_t dataVersion{ 0 };
+
+    // Background jobs (export etc.) reading items - rows must not be
+    // added/removed while this is non-zero (view changes are fine, jobs
+    // take their own copy of it).  Mutable so readers holding a const
+    // model register too.
+    mutable std::atomic<int> backgroundReaders{ 0 };
+
+    // Column currently sorted on (-1 = insertion order)
+    int sortColumn{ -1 };
+
+    // Ordering when sortColumn isn't one of the model's columns
+    std::shared_ptr<SortKey> sortKey;
+
+    // Sorted largest first (the sort's order reversed)
+    bool sortDescending{ false };
+
+    // Current (case-insensitive) text filter
+    wxString filterText;
+
+    // Current structured filter (nullptr = none)
+    std::shared_ptr<RowFilter> rowFilter;
+
+    // Per-column statistics - the rows holding the longest text in each
+    // column (longest first), so widths can be estimated without a full scan
+    struct ColumnStats {
+
+        std::vector<size_t> longestRows;    // longest first
+        std::vector<size_t> lengths;        // of longestRows
+    };
+
+    static constexpr int ColumnCount = 3;
+    static constexpr size_t LongestTracked = 16;
+
+    // Blocks of a source decoded for its column statistics
+    static constexpr size_t StatsSampleBlocks = 64;
+
+
+    // Readahead covers this much scrolling at the current scroll speed...
+    static constexpr double ReadaheadSeconds = 0.5;
+
+    // ...but never more rows than this
+    static constexpr long MaxReadaheadRows = 64 * 1024;
+
+
+    // Number of rows the list shows
+    size_t rowCount() const { return sortedView ? sortedView->size() : view.size(); }
+
+    // Number of rows in the model (shown or not)
+    size_t totalRows() const { return source ? source->rowCount() : items.size(); }
+
+    // Map a list (view) index to the row in items
+    size_t modelRow(long viewIndex) const { return sortedView ? (*sortedView)[sortedPosition(viewIndex)] : view[viewIndex]; }
+
+    // Position in sortedView of a list index - the file is ascending, a
+    // descending order reads it back to front
+    size_t sortedPosition(size_t viewIndex) const { return sortDescending ? sortedView->size() - 1 - viewIndex : viewIndex; }
+
+    // Copy of the display order (for background jobs)
+    std::vector<size_t> viewRows() const {
+
+        if (!sortedView) {
+            return view;
+        }
+
+        std::vector<size_t> rows(sortedView->size());
+
+        for (size_t i = 0; i < rows.size(); i++) {
+            rows[i] = (*sortedView)[sortedPosition(i)];
+        }
+
+        return rows;
+    }
+
+    // Row by model index - UI thread only (background jobs use backgroundReader).
+    // With a source, the reference is valid for the next few row() calls.
+    const ItemData& row(size_t index) const { return source ? reader->row(index) : items[index]; }
+
+    const ItemData& itemAt(long viewIndex) const { return row(modelRow(viewIndex)); }
+
+    // Reader for a worker thread (nullptr when rows are in items, which can
+    // be read directly)
+    std::unique_ptr<RowReader> backgroundReader() const {
+
+        return source ? std::make_unique<RowReader>(*cache) : nullptr;
+    }
+
+    // Switch to rows from a source (nullptr goes back to items)
+    void attachSource(std::shared_ptr<RowSource> newSource) {
+
+        prefetcher.reset();
+        reader.reset();
+        cache.reset();
+
+        source = newSource;
+        items.clear();
+        items.shrink_to_fit();
+
+        if (source) {
+            cache = std::make_unique<BlockCache>(*source, source->cacheBlocks());
+            reader = std::make_unique<RowReader>(*cache);
+            prefetcher = std::make_unique<BlockPrefetcher>(*source, *cache);
+        }
+
+        rowsChanged();
+    }
+
+    // Copy every row into items and drop the source
+    void loadIntoMemory() {
+
+        if (!source) {
+            return;
+        }
+
+        std::vector<ItemData> rows;
+        rows.reserve(totalRows());
+
+        for (size_t r = 0; r < totalRows(); r++) {
+            rows.push_back(row(r));
+        }
+
+        attachSource(nullptr);
+
+        items = std::move(rows);
+        rowsChanged();
+    }
+
+    // The list is about to show view rows [from, to] (wxEVT_LIST_CACHE_HINT).
+    // Decode them plus a readahead window in the scroll direction on the
+    // prefetch thread - the window grows with scroll speed so fast
+    // scrolling stays ahead of the decoder.
+    void cacheHint(long from, long to) {
+
+        if (!source || rowCount() == 0) {
+            return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - lastHintTime).count();
+
+        // smoothed rows/second, reset after a pause
+        if (seconds > 0 && seconds < 1.0) {
+            double speed = std::abs(from - lastHintFrom) / seconds;
+            scrollSpeed = 0.5 * scrollSpeed + 0.5 * speed;
+        }
+        else {
+            scrollSpeed = 0;
+        }
+
+        bool forward = from >= lastHintFrom;
+        lastHintFrom = from;
+        lastHintTime = now;
+
+        long last = static_cast<long>(rowCount()) - 1;
+        from = std::clamp(from, 0L, last);
+        to = std::clamp(to, from, last);
+
+        long page = to - from + 1;
+        long window = std::clamp(static_cast<long>(scrollSpeed * ReadaheadSeconds), page, MaxReadaheadRows);
+
+        if (sortedView) {
+            long first = forward ? from : std::max(from - window, 0L);
+            long count = std::min(to + window, last) - first + 1;
+            sortedView->willNeed(sortDescending ? sortedPosition(first + count - 1) : first, count);
+        }
+
+        std::vector<size_t> blocks;
+        std::unordered_set<size_t> seen;
+
+        auto addRows = [&](long first, long end, long step) {
+            for (long i = first; i != end && blocks.size() < cache->capacityBlocks() / 2; i += step) {
+                size_t block = modelRow(i) / RowSource::BlockRows;
+                if (seen.insert(block).second) {
+                    blocks.push_back(block);
+                }
+            }
+            };
+
+        addRows(from, to + 1, 1);
+
+        if (forward) {
+            addRows(to + 1, std::min(to + window, last) + 1, 1);
+        }
+        else {
+            addRows(from - 1, std::max(from - window, 0L) - 1, -1);
+        }
+
+        // Start the reads for contiguous runs (unsorted view)
+        if (sortColumn < 0 && filterText.IsEmpty() && !blocks.empty()) {
+            auto range = std::minmax_element(blocks.begin(), blocks.end());
+            source->willNeed(*range.first, *range.second);
+        }
+
+        prefetcher->request(std::move(blocks));
+    }
+
+    // Text of one cell - shared by the list and anything else formatting rows
+    static wxString cellText(const ItemData& item, long column) {
+
+        switch (column) {
+        case 0: return std::to_string(item.id);
+        case 1: return item.name;
+        case 2: return item.description;
+        default: return wxString("");
+        }
+    }
+
+    // Length (in characters) of a cell's text
+    static size_t cellLength(const ItemData& item, long column) {
+
+        switch (column) {
+        case 0: return digitCount(item.id);
+        case 1: return item.name.length();
+        case 2: return item.description.length();
+        default: return 0;
+        }
+    }
+
+    static size_t digitCount(int value) {
+
+        size_t digits = (value < 0) ? 2 : 1;
+
+        for (long long v = std::abs(static_cast<long long>(value)); v >= 10; v /= 10) {
+            digits++;
+        }
+
+        return digits;
+    }
+
+    // Call after adding/removing/editing rows - drops stats, rebuilds view
+    void rowsChanged() {
+
+        statsValid = false;
+        dataVersion++;
+        rebuildView();
+    }
+
+    // Statistics for a column (computed on first use after rows change, then
+    // kept up to date as in-memory rows are appended or updated)
+    const ColumnStats& columnStats(int column) {
+
+        if (!statsValid) {
+            computeStats();
+        }
+
+        return stats[column];
+    }
+
+    // Rebuild view from items - call after adding/removing rows
+    void rebuildView() {
+
+        size_t total = totalRows();
+
+        sortedView.reset();
+
+        view.clear();
+
+        // unfiltered and still sorted on disk - show that order again
+        if (!rowFilter && filterText.IsEmpty() && diskOrderValid()) {
+
+            view.shrink_to_fit();
+            sortedView = diskOrder;
+
+            version++;
+            return;
+        }
+
+        view.reserve(total);
+
+        if (rowFilter) {
+
+            rowFilter->select(*this, view);
+
+            if (!filterText.IsEmpty()) {
+                view.erase(std::remove_if(view.begin(), view.end(), [this](size_t r) { return !matchesFilter(row(r)); }), view.end());
+            }
+        }
+        else if (filterText.IsEmpty()) {
+
+            view.resize(total);
+            std::iota(view.begin(), view.end(), size_t{ 0 });
+        }
+        else {
+
+            for (size_t i = 0; i < total; i++) {
+
+                if (matchesFilter(row(i))) {
+                    view.push_back(i);
+                }
+            }
+        }
+
+        orderView();
+    }
+
+    // diskOrder still orders the rows the way they are sorted
+    bool diskOrderValid() const {
+
+        return diskOrder && diskOrderColumn == sortColumn && !sortKey && diskOrderVersion == dataVersion;
+    }
+
+    // Sort view on a column (0 = id, 1 = name, 2 = description)
+    void sortByColumn(int column) {
+
+        sortColumn = column;
+        sortKey.reset();
+        sortDescending = false;
+        sortedView ? rebuildView() : sortView();
+    }
+
+    // Already sorted on column (by key, for a computed column)?
+    bool isSortedOn(int column, const std::shared_ptr<SortKey>& key = nullptr) const {
+
+        return column >= 0 && column == sortColumn && key == sortKey;
+    }
+
+    // Flip between ascending and descending on the current sort column -
+    // the shown order is reversed in place (O(n)), or read backwards when
+    // sorted on disk (O(1)), instead of sorting again
+    void reverseOrder() {
+
+        if (sortColumn < 0) {
+            return;
+        }
+
+        sortDescending = !sortDescending;
+
+        if (!sortedView) {
+            std::reverse(view.begin(), view.end());
+        }
+
+        version++;
+    }
+
+    // Show rows in an order sorted outside the model (on disk) - replaces
+    // view until the next sort, filter or data change
+    void useSortedView(int column, std::shared_ptr<MappedPermutation> order) {
+
+        sortColumn = column;
+        sortKey.reset();
+        sortDescending = false;
+
+        view.clear();
+        view.shrink_to_fit();
+        sortedView = order;
+
+        diskOrder = std::move(order);
+        diskOrderColumn = column;
+        diskOrderVersion = dataVersion;
+
+        version++;
+    }
+
+    // Sort view on a column ordered by key (e.g. a computed column)
+    void sortByKey(int column, std::shared_ptr<SortKey> key) {
+
+        sortColumn = column;
+        sortKey = std::move(key);
+        sortDescending = false;
+        sortedView ? rebuildView() : sortView();
+    }
+
+    // What applyUpdate did - model rows are indices after the update
+    struct UpdateResult {
+
+        std::vector<size_t> changedRows;    // updated in place or inserted
+        size_t inserted{ 0 };
+        size_t deleted{ 0 };
+        size_t updated{ 0 };
+    };
+
+    // Bring items in line with fresh rows, keyed by id, touching only rows
+    // that differ: deleted rows are removed, changed rows updated in place,
+    // new rows appended.  view is patched rather than rebuilt - surviving
+    // rows keep their order and new ones are inserted at their sorted
+    // position.  In-memory rows only (not with a source).
+    UpdateResult applyUpdate(std::vector<ItemData>& fresh) {
+
+        UpdateResult result;
+
+        std::unordered_map<int, size_t> freshById;
+        freshById.reserve(fresh.size());
+
+        for (size_t i = 0; i < fresh.size(); i++) {
+            freshById.emplace(fresh[i].id, i);
+        }
+
+        std::vector<uint8_t> freshUsed(fresh.size(), 0);
+
+        // Update/delete existing rows, compacting items as we go
+        const size_t Deleted = static_cast<size_t>(-1);
+        std::vector<size_t> remap(items.size(), Deleted);
+        std::vector<size_t> changed;
+        size_t kept = 0;
+
+        for (size_t r = 0; r < items.size(); r++) {
+
+            auto found = freshById.find(items[r].id);
+
+            if (found == freshById.end() || freshUsed[found->second]) {
+                result.deleted++;
+                continue;
+            }
+
+            freshUsed[found->second] = 1;
+            ItemData& incoming = fresh[found->second];
+
+            if (items[r].name != incoming.name || items[r].description != incoming.description) {
+                items[r] = std::move(incoming);
+                changed.push_back(kept);
+                result.updated++;
+            }
+
+            if (kept != r) {
+                items[kept] = std::move(items[r]);
+            }
+
+            remap[r] = kept++;
+        }
+
+        items.resize(kept);
+
+        // Patch the view - drop deleted rows, renumber the rest
+        size_t out = 0;
+
+        for (size_t i = 0; i < view.size(); i++) {
+            if (remap[view[i]] != Deleted) {
+                view[out++] = remap[view[i]];
+            }
+        }
+
+        view.resize(out);
+
+        // Updated rows whose sort key changed, or that may now fail (or
+        // newly pass) the filter, are taken out and placed again below
+        std::vector<size_t> place;
+
+        bool keyChanged = (sortColumn == 1 || sortColumn == 2 || sortKey);
+        bool filtered = !filterText.IsEmpty() || rowFilter;
+
+        if ((keyChanged || filtered) && !changed.empty()) {
+
+            std::unordered_set<size_t> moving(changed.begin(), changed.end());
+
+            view.erase(std::remove_if(view.begin(), view.end(), [&moving](size_t r) { return moving.count(r) != 0; }), view.end());
+            place = changed;
+        }
+
+        // Append new rows
+        for (size_t i = 0; i < fresh.size(); i++) {
+            if (!freshUsed[i]) {
+                items.push_back(std::move(fresh[i]));
+                changed.push_back(items.size() - 1);
+                place.push_back(items.size() - 1);
+                result.inserted++;
+            }
+        }
+
+        // Row contents changed - keyed caches (and sortKey) start over
+        updateStats(remap, changed);
+        dataVersion++;
+
+        // Binary insertion for a few rows, one sort for many (or for a
+        // sort key, which has to recompute its keys anyway)
+        bool many = place.size() > view.size() / 8 + 16 || (sortKey && !place.empty());
+
+        for (size_t r : place) {
+
+            if (!filterText.IsEmpty() && !matchesFilter(items[r])) {
+                continue;
+            }
+
+            if (rowFilter && !rowFilter->matches(*this, items[r])) {
+                continue;
+            }
+
+            if (many) {
+                view.push_back(r);
+            }
+            else {
+                auto at = std::upper_bound(view.begin(), view.end(), r, [this](size_t r1, size_t r2) { return rowLess(r1, r2); });
+                view.insert(at, r);
+            }
+        }
+
+        if (many) {
+
+            if (sortColumn < 0) {
+                std::sort(view.begin(), view.end());
+            }
+            else {
+                sortView();
+            }
+        }
+
+        version++;
+
+        result.changedRows = std::move(changed);
+        return result;
+    }
+
+    // Rows were appended to items from first on - add the ones passing the
+    // filters to the view at their sorted positions.  In-memory rows only.
+    void rowsAppended(size_t first) {
+
+        if (statsValid) {
+            trackLongest(first, items.size());
+        }
+
+        dataVersion++;
+
+        if (sortedView) {
+            rebuildView();
+            return;
+        }
+
+        size_t old = view.size();
+
+        for (size_t r = first; r < items.size(); r++) {
+
+            if (!filterText.IsEmpty() && !matchesFilter(items[r])) {
+                continue;
+            }
+
+            if (rowFilter && !rowFilter->matches(*this, items[r])) {
+                continue;
+            }
+
+            view.push_back(r);
+        }
+
+        // new rows come after the old ones in model order, so unsorted
+        // there is nothing to do; sorted, sort just them and merge
+        if (sortKey) {
+            sortView();
+            return;
+        }
+
+        if (sortColumn >= 0) {
+
+            auto less = [this](size_t r1, size_t r2) { return rowLess(r1, r2); };
+
+            std::stable_sort(view.begin() + old, view.end(), less);
+            std::inplace_merge(view.begin(), view.begin() + old, view.end(), less);
+        }
+
+        version++;
+    }
+
+    // Ordering of two rows on the current sort column and direction (model
+    // order unsorted)
+    bool rowLess(size_t r1, size_t r2) const {
+
+        if (sortDescending) {
+            std::swap(r1, r2);
+        }
+
+        switch (sortColumn) {
+        case 0: return row(r1).id < row(r2).id;
+        case 1: return row(r1).name < row(r2).name;
+        case 2: return row(r1).description < row(r2).description;
+        default: return sortKey ? sortKey->less(r1, r2) : r1 < r2;
+        }
+    }
+
+    // Add the memory held by rows, indexes and caches
+    void memoryUsage(MemoryUsage& usage) const {
+
+        size_t ids = items.size() * sizeof(int);
+        size_t names = items.size() * sizeof(wxString);
+        size_t descriptions = names;
+
+        for (auto& item : items) {
+            names += MemoryUsage::stringHeapBytes(item.name);
+            descriptions += MemoryUsage::stringHeapBytes(item.description);
+        }
+
+        if (!items.empty()) {
+
+            usage.add("Column", "id", ids);
+            usage.add("Column", "name", names);
+            usage.add("Column", "description", descriptions);
+            usage.add("Column", "row padding + unused capacity", MemoryUsage::vectorBytes(items) - ids - 2 * items.size() * sizeof(wxString));
+        }
+
+        if (source) {
+            source->memoryUsage(usage);
+        }
+
+        usage.add("Index", "view (sort/filter permutation)", MemoryUsage::vectorBytes(view));
+
+        if (sortedView) {
+            usage.add("Storage", "view sorted on disk (mapped)", sortedView->size() * sizeof(uint64_t));
+        }
+
+        size_t statsBytes = 0;
+
+        for (auto& column : stats) {
+            statsBytes += MemoryUsage::vectorBytes(column.longestRows) + MemoryUsage::vectorBytes(column.lengths);
+        }
+
+        usage.add("Index", "column statistics", statsBytes);
+        usage.add("Index", "id column (query scans)", MemoryUsage::vectorBytes(this->ids));
+
+        if (cache) {
+            usage.add("Cache", "decoded row blocks", cache->memoryBytes());
+        }
+    }
+
+    // Only show rows containing text (in any column), empty string shows all
+    void applyFilter(const wxString& text) {
+
+        filterText = text.Lower();
+        rebuildView();
+    }
+
+    // Only show rows passing filter (nullptr shows all)
+    void applyRowFilter(std::shared_ptr<RowFilter> filter) {
+
+        rowFilter = std::move(filter);
+        rebuildView();
+    }
+
+    // Show rows a filter has already selected - e.g. the partial or final
+    // result of a background scan - without rescanning.  Partial results
+    // (complete false) arrive several times a second and are shown in the
+    // order given (see appendFilterResult); only the final one is put in
+    // sort order.
+    void showFilterResult(std::shared_ptr<RowFilter> filter, std::vector<size_t> rows, bool complete) {
+
+        rowFilter = std::move(filter);
+        sortedView.reset();
+
+        view = std::move(rows);
+
+        if (!filterText.IsEmpty()) {
+            view.erase(std::remove_if(view.begin(), view.end(), [this](size_t r) { return !matchesFilter(row(r)); }), view.end());
+        }
+
+        if (complete) {
+            orderView();
+        }
+        else {
+            version++;
+        }
+    }
+
+    // Add more rows the filter shown by showFilterResult has selected, at the
+    // end - the cost is the new rows, not everything shown so far
+    void appendFilterResult(const std::vector<size_t>& rows) {
+
+        size_t old = view.size();
+
+        view.insert(view.end(), rows.begin(), rows.end());
+
+        if (!filterText.IsEmpty()) {
+            view.erase(std::remove_if(view.begin() + old, view.end(), [this](size_t r) { return !matchesFilter(row(r)); }), view.end());
+        }
+
+        version++;
+    }
+
+    // Ids as a plain column, for vectorized scans (rebuilt after rows change)
+    const std::vector<int32_t>& idColumn() const {
+
+        if (idsVersion != dataVersion || ids.size() != totalRows()) {
+
+            ids.resize(totalRows());
+
+            for (size_t r = 0; r < ids.size(); r++) {
+                ids[r] = row(r).id;
+            }
+
+            idsVersion = dataVersion;
+        }
+
+        return ids;
+    }
+
+private:
+
+    ColumnStats stats[ColumnCount];
+    bool statsValid{ false };
+
+    // What diskOrder is sorted on and the data it was sorted from
+    int diskOrderColumn{ -1 };
+    uint64_t diskOrderVersion{ 0 };
+
+    // See idColumn
+    mutable std::vector<int32_t> ids;
+    mutable uint64_t idsVersion{ ~uint64_t{ 0 } };
+
+    // Block cache, UI thread reader and prefetcher for source rows
+    std::unique_ptr<BlockCache> cache;
+    mutable std::unique_ptr<RowReader> reader;
+    std::unique_ptr<BlockPrefetcher> prefetcher;
+
+    // Scroll speed tracking for the readahead window
+    long lastHintFrom{ 0 };
+    std::chrono::steady_clock::time_point lastHintTime;
+    double scrollSpeed{ 0 };
+
+    // Longest cells per column - exact for in-memory rows (a pass over
+    // items, no decoding).  A source would have to decode every block on
+    // the UI thread, so its stats come from a sample of blocks spread over
+    // the rows (autofit measures a sample of the view as well).
+    void computeStats() {
+
+        for (auto& column : stats) {
+            column.longestRows.clear();
+            column.lengths.clear();
+        }
+
+        size_t total = totalRows();
+
+        if (!source) {
+            trackLongest(0, total);
+        }
+        else {
+
+            size_t blocks = (total + RowSource::BlockRows - 1) / RowSource::BlockRows;
+            size_t strata = std::min(blocks, StatsSampleBlocks);
+
+            for (size_t s = 0; s < strata; s++) {
+
+                size_t begin = s * blocks / strata;
+                size_t end = (s + 1) * blocks / strata;
+                size_t first = (begin + (s * 2654435761u) % (end - begin)) * RowSource::BlockRows;
+
+                trackLongest(first, std::min(first + RowSource::BlockRows, total));
+            }
+        }
+
+        statsValid = true;
+    }
+
+    // Merge rows [first, end) into the longest cells per column
+    void trackLongest(size_t first, size_t end) {
+
+        for (size_t r = first; r < end; r++) {
+
+            const ItemData& item = row(r);
+
+            for (int column = 0; column < ColumnCount; column++) {
+
+                auto& lengths = stats[column].lengths;
+                size_t length = cellLength(item, column);
+
+                if (lengths.size() == LongestTracked && length <= lengths.back()) {
+                    continue;
+                }
+
+                auto at = std::upper_bound(lengths.begin(), lengths.end(), length, std::greater<size_t>()) - lengths.begin();
+
+                lengths.insert(lengths.begin() + at, length);
+                stats[column].longestRows.insert(stats[column].longestRows.begin() + at, r);
+
+                if (lengths.size() > LongestTracked) {
+                    lengths.pop_back();
+                    stats[column].longestRows.pop_back();
+                }
+            }
+        }
+    }
+
+    // After applyUpdate: renumber the tracked rows and merge the changed
+    // ones.  A tracked row that was deleted or edited may have been one of
+    // the longest, and the next longest isn't known - start over then
+    // (in-memory rows, so that is a pass over items, not a decode).
+    void updateStats(const std::vector<size_t>& remap, const std::vector<size_t>& changed) {
+
+        if (!statsValid) {
+            return;
+        }
+
+        std::unordered_set<size_t> edited(changed.begin(), changed.end());
+
+        for (auto& column : stats) {
+
+            for (size_t& r : column.longestRows) {
+
+                r = remap[r];
+
+                if (r == static_cast<size_t>(-1) || edited.count(r)) {
+                    statsValid = false;
+                    return;
+                }
+            }
+        }
+
+        for (size_t r : changed) {
+            trackLongest(r, r + 1);
+        }
+    }
+
+    bool matchesFilter(const ItemData& item) const {
+
+        return item.name.Lower().Contains(filterText)
+            || item.description.Lower().Contains(filterText)
+            || wxString(std::to_string(item.id)).Contains(filterText);
+    }
+
+    // Put view (a set of rows) in the current sort order - by picking them
+    // out of the on-disk order (a sequential pass, no row decoding) when it
+    // is still valid, or by sorting
+    void orderView() {
+
+        if (!diskOrderValid()) {
+            sortView();
+            return;
+        }
+
+        std::vector<bool> shown(totalRows(), false);
+
+        for (size_t r : view) {
+            shown[r] = true;
+        }
+
+        size_t count = view.size();
+        view.clear();
+
+        for (size_t i = 0; i < diskOrder->size() && view.size() < count; i++) {
+
+            size_t r = (*diskOrder)[i];
+
+            if (shown[r]) {
+                view.push_back(r);
+            }
+        }
+
+        if (sortDescending) {
+            std::reverse(view.begin(), view.end());
+        }
+
+        version++;
+    }
+
+    void sortView() {
+
+        // stable so equal keys keep their previous relative order
+        switch (sortColumn) {
+
+        case 0: // id
+            std::stable_sort(view.begin(), view.end(), [this](size_t r1, size_t r2)->bool {
+                return row(r1).id < row(r2).id;
+                });
+            break;
+        case 1: // name
+            std::stable_sort(view.begin(), view.end(), [this](size_t r1, size_t r2)->bool {
+                return row(r1).name < row(r2).name;
+                });
+            break;
+        case 2: // description
+            std::stable_sort(view.begin(), view.end(), [this](size_t r1, size_t r2)->bool {
+                return row(r1).description < row(r2).description;
+                });
+            break;
+        default:
+            if (sortKey) {
+                sortKey->prepare(*this, view);
+                std::stable_sort(view.begin(), view.end(), [this](size_t r1, size_t r2)->bool {
+                    return sortKey->less(r1, r2);
+                    });
+            }
+            break;
+        }
+
+        if (sortDescending) {
+            std::reverse(view.begin(), view.end());
+        }
+
+        version++;
+    }
+};
+
+
+// Row access for worker threads - reads items directly, or rows from a
+// source through a reader of its own
+class RowCursor {
+
+public:
+
+    explicit RowCursor(const ListModel& model) : model(model), reader(model.backgroundReader()) {}
+
+    const ItemData& operator[](size_t index) {
+
+        return reader ? reader->row(index) : model.items[index];
+    }
+
+private:
+
+    const ListModel& model;
+    std::unique_ptr<RowReader> reader;
+};
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+
+// Small LZ77 block codec in the style of LZ4 - byte aligned, no entropy
+// coding, so decoding is a tight copy loop (GB/s) and text typically
+// shrinks 2-4x.  Each call compresses one independent block.
+//
+// Sequence: token (literal length << 4 | match length - 4), extra literal
+// length bytes (255 = keep adding), literals, 16 bit match offset, extra
+// match length bytes.  The last sequence has literals only.
+namespace LzBlock {
+
+    constexpr size_t MinMatch = 4;
+    constexpr size_t HashBits = 12;
+    constexpr size_t MaxOffset = 65535;
+
+    inline uint32_t read32(const char* p) {
+
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline size_t hash(uint32_t v) {
+
+        return (v * 2654435761u) >> (32 - HashBits);
+    }
+
+    inline void writeLength(std::string& out, size_t length) {
+
+        while (length >= 255) {
+            out.push_back(static_cast<char>(255));
+            length -= 255;
+        }
+
+        out.push_back(static_cast<char>(length));
+    }
+
+    inline void writeSequence(std::string& out, const char* literals, size_t literalLength, size_t offset, size_t matchLength) {
+
+        size_t matchCode = matchLength ? matchLength - MinMatch : 0;
+
+        uint8_t token = static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15));
+        out.push_back(static_cast<char>(token));
+
+        if (literalLength >= 15) {
+            writeLength(out, literalLength - 15);
+        }
+
+        out.append(literals, literalLength);
+
+        if (matchLength == 0) {
+            return; // last sequence
+        }
+
+        out.push_back(static_cast<char>(offset & 0xFF));
+        out.push_back(static_cast<char>(offset >> 8));
+
+        if (matchCode >= 15) {
+            writeLength(out, matchCode - 15);
+        }
+    }
+
+    // Append the compressed form of src[0, size) to out
+    inline void compress(const char* src, size_t size, std::string& out) {
+
+        uint32_t table[1 << HashBits] = {}; // position + 1, 0 = empty
+
+        size_t anchor = 0;
+        size_t at = 0;
+
+        // leave room so read32 never runs past the end
+        const size_t limit = (size > MinMatch) ? size - MinMatch : 0;
+
+        while (at < limit) {
+
+            uint32_t sequence = read32(src + at);
+            size_t slot = hash(sequence);
+            size_t candidate = table[slot];
+            table[slot] = static_cast<uint32_t>(at + 1);
+
+            if (candidate == 0 || at - (candidate - 1) > MaxOffset || read32(src + candidate - 1) != sequence) {
+                at++;
+                continue;
+            }
+
+            size_t match = candidate - 1;
+            size_t length = MinMatch;
+
+            while (at + length < size && src[match + length] == src[at + length]) {
+                length++;
+            }
+
+            writeSequence(out, src + anchor, at - anchor, at - match, length);
+
+            at += length;
+            anchor = at;
+        }
+
+        writeSequence(out, src + anchor, size - anchor, 0, 0);
+    }
+
+    inline bool readLength(const uint8_t*& p, const uint8_t* end, size_t& length) {
+
+        uint8_t b;
+
+        do {
+            if (p >= end) {
+                return false;
+            }
+
+            b = *p++;
+            length += b;
+        } while (b == 255);
+
+        return true;
+    }
+
+    // Decompress exactly dstSize bytes - false if the input is malformed
+    inline bool decompress(const char* src, size_t srcSize, char* dst, size_t dstSize) {
+
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(src);
+        const uint8_t* end = p + srcSize;
+        size_t out = 0;
+
+        while (p < end) {
+
+            uint8_t token = *p++;
+            size_t literalLength = token >> 4;
+
+            if (literalLength == 15 && !readLength(p, end, literalLength)) {
+                return false;
+            }
+
+            if (literalLength > static_cast<size_t>(end - p) || literalLength > dstSize - out) {
+                return false;
+            }
+
+            std::memcpy(dst + out, p, literalLength);
+            p += literalLength;
+            out += literalLength;
+
+            if (p == end) {
+                break; // last sequence
+            }
+
+            if (end - p < 2) {
+                return false;
+            }
+
+            size_t offset = p[0] | (p[1] << 8);
+            p += 2;
+
+            size_t matchLength = token & 0x0F;
+
+            if (matchLength == 15 && !readLength(p, end, matchLength)) {
+                return false;
+            }
+
+            matchLength += MinMatch;
+
+            if (offset == 0 || offset > out || matchLength > dstSize - out) {
+                return false;
+            }
+
+            // byte by byte - matches may overlap their own output
+            const char* from = dst + out - offset;
+
+            for (size_t i = 0; i < matchLength; i++) {
+                dst[out + i] = from[i];
+            }
+
+            out += matchLength;
+        }
+
+        return out == dstSize;
+    }
+}
@@ -4,70 +4,93 @@
 
 #include <wx/imagpng.h>
 #include <wx/gdicmn.h>
+#include <wx/fswatcher.h>
+#include <wx/filename.h>
+#include <wx/dir.h>
+#include <wx/stdpaths.h>
+#include <wx/numdlg.h>
+
+#include "listmodel.h"
+#include "virtuallist.h"
+#include "exporter.h"
+#include "itemfile.h"
+#include "compressedrows.h"
+#include "memorydialog.h"
+#include "clipboardcopy.h"
+#include "externalsort.h"
+#include "filterquery.h"
+#include "progressivequery.h"
+#include "ringfeed.h"
 
 using namespace std;
 
 
-struct ItemData {
-
-    int         id;
-    wxString    name;
-    wxString    description;
-};
-
-class ListModel {
-
-public:
-    vector<ItemData> items;
-};
-
-
-
-// Virtual list subclass - virtual lists special case of report view
-class VirtualList : public wxListCtrl {
+// Shows the result of comparing two models - owns the merged model
+class CompareFrame : public wxFrame {
 
 private:
 
-    // Store reference to model
-    ListModel* hostModel{ nullptr };
+    unique_ptr<ListModel> model;
 
-public:
+    VirtualList* listView{ nullptr };
 
-    VirtualList(wxWindow* parent, const wxWindowID id, const wxPoint& pos, const wxSize& size, ListModel *model) : wxListCtrl(parent, id, pos, size, wxLC_REPORT | wxLC_VIRTUAL | wxLC_EDIT_LABELS) {
+public:
 
-        // Link to model
-        this->hostModel = model;
+    CompareFrame(wxWindow* parent, const wxString& title, MergeResult merged) :
+        wxFrame(parent, wxID_ANY, title, wxDefaultPosition, wxSize(1024, 768)) {
 
-        // Setup list columns
-        AppendColumn("ID");
-        AppendColumn("Name");
-        AppendColumn("Description");
+        model = make_unique<ListModel>();
+        model->items = std::move(merged.rows);
+        model->rowsChanged();
 
-        SetColumnWidth(0, 80);
-        SetColumnWidth(1, 120);
-        SetColumnWidth(2, 600);
-    }
+        wxPanel* panel = new wxPanel(this);
+        wxBoxSizer* sizer = new wxBoxSizer(wxVERTICAL);
 
-    // Override method to query data for list element
-    virtual wxString OnGetItemText(long index, long column) const override {
+        panel->SetSizer(sizer);
 
-        ItemData item = hostModel->items[index];
+        listView = new VirtualList(panel, wxID_ANY, wxDefaultPosition, wxDefaultSize, model.get());
+        sizer->Add(listView, 1, wxALL | wxEXPAND, 0);
 
-        switch (column) {
-        case 0: return std::to_string(item.id);
-        case 1: return item.name;
-        case 2: return item.description;
-        default: return wxString("");
-        }
-    }
+        listView->setRowChanges(std::move(merged.changes));
+        listView->RefreshAfterUpdate();
+        listView->autoFitColumns();
 
-    // Refresh list count and update list itself once changes made
-    void RefreshAfterUpdate() {
+        listView->Bind(wxEVT_LIST_COL_CLICK, [this](wxListEvent event) {
+            this->model->sortByColumn(event.GetColumn());
+            this->listView->RefreshAfterUpdate();
+            });
 
-        SetItemCount(hostModel->items.size());
-        Refresh();
+        CreateStatusBar();
+        SetStatusText(wxString::Format("%zu rows: %zu added (green), %zu removed (red), %zu changed (yellow)",
+            model->totalRows(), merged.added, merged.removed, merged.changed));
     }
+};
 
+
+// Menu command ids
+enum {
+    ID_OPEN_BINARY = wxID_HIGHEST + 1,
+    ID_LOAD_BINARY,
+    ID_RELOAD,
+    ID_COMPARE_BINARY,
+    ID_LISTEN_RING,
+    ID_STOP_RING,
+    ID_EXPORT_CSV,
+    ID_EXPORT_BINARY,
+    ID_EXPORT_CANCEL,
+    ID_COPY_CANCEL,
+    ID_QUERY_CANCEL,
+    ID_AUTOFIT_COLUMNS,
+    ID_COMPRESS_TEXT,
+    ID_ADD_COMPUTED_COLUMN,
+    ID_ADD_WIDE_COLUMNS,
+    ID_GROUP_BY,
+    ID_EXPAND_ALL,
+    ID_COLLAPSE_ALL,
+    ID_MEMORY_USAGE,
+    ID_SHOW_THUMBNAILS,
+    ID_ADD_STYLE_RULE,
+    ID_CLEAR_STYLE_RULES
 };
 
 
@@ -79,6 +102,33 @@ private:
 
     VirtualList* listView{ nullptr };
 
+    // Background export of the current view
+    ListExporter exporter;
+
+    // Background copy of the selection to the clipboard
+    ClipboardCopier copier;
+
+    // Sorts file backed rows too many to sort in memory
+    ExternalSorter sorter;
+
+    // Background query over large models, showing matches as they are found
+    ProgressiveQuery queryScan;
+
+    // Background compare with a binary export
+    ModelMerger merger;
+
+    // Rows streamed in from an ingest process through shared memory
+    RingFeed ringFeed;
+    size_t ringRows{ 0 };
+
+    // Active row highlight rules (first match wins)
+    vector<RowStyleRule> styleRules;
+
+    // Binary export loaded into memory - reloaded in place when it changes
+    wxString loadedPath;
+    wxFileSystemWatcher* watcher{ nullptr };
+    wxTimer reloadTimer;
+
 #ifdef _DEBUG
     wxLog* logger = nullptr;
 #endif
@@ -102,6 +152,87 @@ public:
 
         toolbar->Realize();
 
+        // Menus
+        auto fileMenu = new wxMenu();
+        fileMenu->Append(ID_OPEN_BINARY, "&Open Binary Export...");
+        fileMenu->Append(ID_LOAD_BINARY, "&Load Binary Export...");
+        fileMenu->Append(ID_RELOAD, "&Reload\tF5");
+        fileMenu->Append(ID_COMPARE_BINARY, "Co&mpare With Binary Export...");
+        fileMenu->Append(ID_LISTEN_RING, "Receive Rows From &Ingest Process...");
+        fileMenu->Append(ID_STOP_RING, "S&top Receiving Rows");
+        fileMenu->AppendSeparator();
+        fileMenu->Append(ID_EXPORT_CSV, "Export View as &CSV...");
+        fileMenu->Append(ID_EXPORT_BINARY, "Export View as &Binary...");
+        fileMenu->Append(ID_EXPORT_CANCEL, "Cancel E&xport");
+        fileMenu->AppendSeparator();
+        fileMenu->Append(wxID_EXIT);
+
+        auto editMenu = new wxMenu();
+        editMenu->Append(wxID_COPY, "&Copy\tCtrl+C");
+        editMenu->Append(ID_COPY_CANCEL, "Cancel Cop&y");
+        editMenu->Append(ID_QUERY_CANCEL, "Cancel &Query");
+
+        auto viewMenu = new wxMenu();
+        viewMenu->Append(ID_AUTOFIT_COLUMNS, "&Auto-fit Columns");
+        viewMenu->AppendCheckItem(ID_COMPRESS_TEXT, "Com&press Text Columns");
+        viewMenu->Append(ID_ADD_COMPUTED_COLUMN, "Add Co&mputed Column...");
+        viewMenu->Append(ID_ADD_WIDE_COLUMNS, "Add Many Columns...");
+        viewMenu->AppendSeparator();
+        viewMenu->Append(ID_GROUP_BY, "&Group By...");
+        viewMenu->Append(ID_EXPAND_ALL, "&Expand All Groups");
+        viewMenu->Append(ID_COLLAPSE_ALL, "C&ollapse All Groups");
+        viewMenu->AppendSeparator();
+        viewMenu->Append(ID_ADD_STYLE_RULE, "Add &Highlight Rule...");
+        viewMenu->Append(ID_CLEAR_STYLE_RULES, "&Clear Highlight Rules");
+        viewMenu->AppendSeparator();
+        viewMenu->AppendCheckItem(ID_SHOW_THUMBNAILS, "Show &Thumbnails");
+        viewMenu->Append(ID_MEMORY_USAGE, "Memory &Usage...");
+
+        auto menuBar = new wxMenuBar();
+        menuBar->Append(fileMenu, "&File");
+        menuBar->Append(editMenu, "&Edit");
+        menuBar->Append(viewMenu, "&View");
+        SetMenuBar(menuBar);
+        menuBar->Enable(ID_EXPORT_CANCEL, false);
+        menuBar->Enable(ID_RELOAD, false);
+        menuBar->Enable(ID_COPY_CANCEL, false);
+        menuBar->Enable(ID_QUERY_CANCEL, false);
+        menuBar->Enable(ID_STOP_RING, false);
+
+        CreateStatusBar();
+
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->openBinary(); }, ID_OPEN_BINARY);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->loadBinary(); }, ID_LOAD_BINARY);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->reload(); }, ID_RELOAD);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->compareWithBinary(); }, ID_COMPARE_BINARY);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->listenOnRing(); }, ID_LISTEN_RING);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->stopRing("Stopped receiving rows"); }, ID_STOP_RING);
+
+        // Writers often touch a file several times - reload once it settles
+        reloadTimer.SetOwner(this);
+        Bind(wxEVT_TIMER, [this](wxTimerEvent& event) { this->reload(); }, reloadTimer.GetId());
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->exportView(ExportFormat::CSV); }, ID_EXPORT_CSV);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->exportView(ExportFormat::Binary); }, ID_EXPORT_BINARY);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->exporter.cancel(); }, ID_EXPORT_CANCEL);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->copySelection(); }, wxID_COPY);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->copier.cancel(); }, ID_COPY_CANCEL);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->queryScan.cancel(); }, ID_QUERY_CANCEL);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->listView->autoFitColumns(); }, ID_AUTOFIT_COLUMNS);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->compressText(event.IsChecked()); }, ID_COMPRESS_TEXT);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->addComputedColumn(); }, ID_ADD_COMPUTED_COLUMN);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->addWideColumns(); }, ID_ADD_WIDE_COLUMNS);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->groupBy(); }, ID_GROUP_BY);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->listView->setAllExpanded(true); }, ID_EXPAND_ALL);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->listView->setAllExpanded(false); }, ID_COLLAPSE_ALL);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->showMemoryUsage(); }, ID_MEMORY_USAGE);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->showThumbnails(event.IsChecked()); }, ID_SHOW_THUMBNAILS);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->addStyleRule(); }, ID_ADD_STYLE_RULE);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) {
+            this->styleRules.clear();
+            this->listView->setStyleRules(this->styleRules);
+            }, ID_CLEAR_STYLE_RULES);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { this->Close(); }, wxID_EXIT);
+
 #ifdef _DEBUG
         logger = new wxLogWindow(this, "Debug Log", true, true); // cleaner
         wxLog::SetActiveTarget(logger);
@@ -116,6 +247,25 @@ public:
 
         panel->SetSizer(sizer);
 
+        // Filter box - only rows containing the text are shown
+        auto filterBox = new wxTextCtrl(panel, wxID_ANY);
+        filterBox->SetHint("Filter");
+        sizer->Add(filterBox, 0, wxALL | wxEXPAND, 2);
+
+        filterBox->Bind(wxEVT_TEXT, [this, filterBox](wxCommandEvent& event) {
+            this->model->applyFilter(filterBox->GetValue());
+            listView->RefreshAfterUpdate();
+            });
+
+        // Query box - e.g. id > 100 and name startswith "C-", run on Enter
+        auto queryBox = new wxTextCtrl(panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
+        queryBox->SetHint("Query, e.g. id > 100 and name startswith \"C-\" (Enter)");
+        sizer->Add(queryBox, 0, wxALL | wxEXPAND, 2);
+
+        queryBox->Bind(wxEVT_TEXT_ENTER, [this, queryBox](wxCommandEvent& event) {
+            applyQuery(queryBox->GetValue());
+            });
+
         listView = new VirtualList(panel, wxID_ANY, wxDefaultPosition, wxDefaultSize, this->model);
         sizer->Add(listView, 1, wxALL | wxEXPAND, 0);
 
@@ -126,13 +276,20 @@ public:
         this->model->items.push_back({8, "C-big", "max power" });
 
         // Update list based on new data
+        this->model->rowsChanged();
         listView->RefreshAfterUpdate();
+        listView->autoFitColumns();
 
         // Setup event handler for list column clicks
         listView->Bind(wxEVT_LIST_COL_CLICK, [this](wxListEvent event) {
             this->sortByColumn(event.GetColumn());
             });
 
+        // Right click on a header fits just that column
+        listView->Bind(wxEVT_LIST_COL_RIGHT_CLICK, [this](wxListEvent event) {
+            this->listView->autoFitColumn(event.GetColumn());
+            });
+
         // Test other events
         listView->Bind(wxEVT_LIST_ITEM_SELECTED, [this](wxListEvent event) {
             wxLogDebug("item %d selected: column %d", event.GetIndex(), event.GetColumn());
@@ -148,31 +305,634 @@ public:
         sizer->Add(button);
     }
 
-    // Sort model and update list
-    void sortByColumn(int column) {
+    ~ListFrame() {
 
-        switch (column) {
+        delete watcher;
+    }
 
-        case 0: // id
-            std::sort(model->items.begin(), model->items.end(), [](ItemData i1, ItemData i2)->bool {
-                return i1.id < i2.id;
-                });
-            break;
-        case 1: // name
-            std::sort(model->items.begin(), model->items.end(), [](ItemData i1, ItemData i2)->bool {
-                return i1.name < i2.name;
-                });
-            break;
-        case 2: // description
-            std::sort(model->items.begin(), model->items.end(), [](ItemData i1, ItemData i2)->bool {
-                return i1.description < i2.description;
+    // Thumbnails of the coffee images from Resources, one per row by id
+    void showThumbnails(bool show) {
+
+        if (!show) {
+            listView->showThumbnails(nullptr);
+            return;
+        }
+
+        // installed next to the executable, or the source tree's
+        wxArrayString images;
+        wxString exeDir = wxFileName(wxStandardPaths::Get().GetExecutablePath()).GetPath();
+
+        for (auto dir : { exeDir + "/Resources", exeDir + "/../Resources", exeDir + "/../../Resources", wxString("../Resources") }) {
+
+            if (wxDir::Exists(dir) && wxDir::GetAllFiles(dir, &images, "coffee*", wxDIR_FILES) > 0) {
+                break;
+            }
+        }
+
+        if (images.IsEmpty()) {
+            wxLogError("No coffee* images found in a Resources folder");
+            GetMenuBar()->Check(ID_SHOW_THUMBNAILS, false);
+            return;
+        }
+
+        images.Sort();
+
+        listView->showThumbnails([images](const ItemData& item) {
+            return images[static_cast<size_t>(std::abs(static_cast<long long>(item.id))) % images.size()];
+            });
+    }
+
+    // Filter rows with a query (empty shows all)
+    void applyQuery(const wxString& text) {
+
+        queryScan.discard();
+        GetMenuBar()->Enable(ID_QUERY_CANCEL, false);
+
+        if (wxString(text).Trim().Trim(false).IsEmpty()) {
+            model->applyRowFilter(nullptr);
+            listView->RefreshAfterUpdate();
+            SetStatusText("Query cleared");
+            return;
+        }
+
+        wxString error;
+        auto query = FilterQuery::compile(text, error);
+
+        if (!query) {
+            SetStatusText("Query error: " + error);
+            return;
+        }
+
+        // Large models - show matches (and an estimated count) as the scan
+        // finds them
+        if (model->totalRows() >= ProgressiveQuery::MinRows) {
+
+            // shared - a superseded query's onDone never runs
+            auto timer = std::make_shared<wxStopWatch>();
+
+            // matches are added as they are found
+            model->showFilterResult(query, {}, false);
+            listView->RefreshAfterUpdate();
+
+            queryScan.start(*model, query, this,
+                [this](const QueryProgress& progress, ProgressiveQuery::Rows rows) {
+
+                    model->appendFilterResult(*rows);
+                    listView->RefreshAfterUpdate();
+
+                    SetStatusText(wxString::Format("Querying... %.0f%% scanned, ~%.0f matches (%.0f - %.0f, 95%%)",
+                        100.0 * progress.scannedRows / progress.totalRows, progress.estimate, progress.low, progress.high));
+                },
+                [this, query, timer](const QueryProgress& progress, ProgressiveQuery::Rows rows, bool cancelled) {
+
+                    model->showFilterResult(query, std::move(*rows), true);
+                    listView->RefreshAfterUpdate();
+                    GetMenuBar()->Enable(ID_QUERY_CANCEL, false);
+
+                    if (cancelled) {
+                        SetStatusText(wxString::Format("Query cancelled - %zu matches in the %.0f%% of rows scanned",
+                            progress.matchedRows, 100.0 * progress.scannedRows / progress.totalRows));
+                    }
+                    else {
+                        SetStatusText(wxString::Format("%zu of %zu rows match (%.2fs)", model->rowCount(), model->totalRows(), timer->Time() / 1000.0));
+                    }
                 });
-            break;
+
+            GetMenuBar()->Enable(ID_QUERY_CANCEL, true);
+            SetStatusText("Querying...");
+            return;
+        }
+
+        wxStopWatch timer;
+
+        model->applyRowFilter(query);
+        listView->RefreshAfterUpdate();
+
+        SetStatusText(wxString::Format("%zu of %zu rows match (%ldms)", model->rowCount(), model->totalRows(), timer.Time()));
+    }
+
+    // Sort model and update list - the sorted column again flips direction
+    void sortByColumn(int column) {
+
+        auto derived = listView->computedColumn(column);
+
+        if (model->isSortedOn(column, derived)) {
+
+            model->reverseOrder();
+            listView->RefreshAfterUpdate();
+
+            SetStatusText(model->sortDescending ? "Sorted descending" : "Sorted ascending");
+            return;
+        }
+
+        // Large file backed rows are sorted on disk in the background
+        if (model->source && column < ListModel::ColumnCount && model->filterText.IsEmpty() && !model->rowFilter
+            && model->totalRows() >= ExternalSorter::MinRows) {
+
+            sortOnDisk(column);
+            return;
+        }
+
+        // Sorts the view permutation only - rows stay where they are
+        if (derived) {
+            model->sortByKey(column, derived);
+        }
+        else {
+            model->sortByColumn(column);
         }
 
         // Once sorted refresh list
         listView->RefreshAfterUpdate();
     }
+
+    // External merge sort - the list keeps showing the old order until the
+    // sorted permutation file is ready, then shows it through a mapping
+    void sortOnDisk(int column) {
+
+        if (sorter.isRunning()) {
+            SetStatusText("A sort is already running");
+            return;
+        }
+
+        auto timer = std::make_shared<wxStopWatch>();
+
+        sorter.start(*model, column, this,
+            [this](const wxString& status) {
+                SetStatusText(status);
+            },
+            [this, column, timer](std::shared_ptr<MappedPermutation> order, const wxString& message) {
+
+                // the order covers every row - not if a filter went on meanwhile
+                if (order && model->filterText.IsEmpty() && !model->rowFilter) {
+                    model->useSortedView(column, order);
+                    listView->RefreshAfterUpdate();
+                }
+
+                SetStatusText(wxString::Format("%s (%.2fs)", message, timer->Time() / 1000.0));
+            });
+
+        SetStatusText("Sorting on disk...");
+    }
+
+    // Ask for an expression (e.g. "len(description)", "bucket(id, 100)",
+    // "concat(name, \" #\", id)") and show it as an extra column
+    void addComputedColumn() {
+
+        wxString text = wxGetTextFromUser("Expression over id, name and description, e.g. len(description), bucket(id, 100), concat(name, \" #\", id)", "Add Computed Column", "", this);
+
+        if (text.IsEmpty()) {
+            return;
+        }
+
+        wxString error;
+        auto column = ComputedColumn::compile(text, error);
+
+        if (!column) {
+            wxLogError("Could not understand '%s': %s", text, error);
+            return;
+        }
+
+        listView->addComputedColumn(column);
+    }
+
+    // Make a very wide table (id * 1, id * 2, ...) - only the columns
+    // scrolled into view are formatted
+    void addWideColumns() {
+
+        long count = wxGetNumberFromUser("Columns are id * 1, id * 2, ...", "Number of columns:", "Add Many Columns", 500, 1, 5000, this);
+
+        if (count <= 0) {
+            return;
+        }
+
+        std::vector<std::shared_ptr<ComputedColumn>> columns;
+        wxString error;
+
+        for (long k = 1; k <= count; k++) {
+            columns.push_back(ComputedColumn::compile(wxString::Format("id * %ld", k), error));
+        }
+
+        wxStopWatch timer;
+        listView->addComputedColumns(columns);
+
+        SetStatusText(wxString::Format("Added %ld columns (%ldms)", count, timer.Time()));
+    }
+
+    // Show the rows as a tree - grouped by a column or expression (e.g.
+    // "name" or "bucket(id, 1000)"); nothing entered goes back to a list
+    void groupBy() {
+
+        wxString text = wxGetTextFromUser("Group rows by a column or expression, e.g. name, bucket(id, 1000) (empty for no groups)", "Group By", "", this);
+
+        if (text.IsEmpty()) {
+            listView->setGrouping(nullptr);
+            return;
+        }
+
+        wxString error;
+        auto key = ComputedColumn::compile(text, error);
+
+        if (!key) {
+            wxLogError("Could not understand '%s': %s", text, error);
+            return;
+        }
+
+        wxBusyCursor busy;
+        listView->setGrouping(key);
+    }
+
+    // Debug panel - where the memory goes (model, list, allocator)
+    void showMemoryUsage() {
+
+        MemoryDialog dialog(this, [this]() {
+
+            MemoryUsage usage;
+            model->memoryUsage(usage);
+            listView->memoryUsage(usage);
+            usage.addProcessHeap();
+            return usage;
+            });
+
+        dialog.ShowModal();
+    }
+
+    // Ask for a rule ("id 10-20", "name C-*", "description *power*") and
+    // add it with the next colour from a small palette
+    void addStyleRule() {
+
+        static const wxColour palette[] = {
+            wxColour(255, 230, 153), wxColour(198, 239, 206), wxColour(189, 215, 238),
+            wxColour(255, 199, 206), wxColour(226, 207, 234)
+        };
+
+        wxString text = wxGetTextFromUser("Rule (e.g. \"id 10-20\", \"name C-*\", \"description *power*\")", "Add Highlight Rule", "", this);
+
+        if (text.IsEmpty()) {
+            return;
+        }
+
+        RowStyleRule rule;
+
+        if (!RowStyleRule::parse(text, palette[styleRules.size() % std::size(palette)], rule)) {
+            wxLogError("Could not understand rule '%s'", text);
+            return;
+        }
+
+        styleRules.push_back(rule);
+        listView->setStyleRules(styleRules);
+    }
+
+    // Show a binary export straight from disk - rows are decoded on demand
+    // (and prefetched from the list's cache hints) instead of loaded
+    void openBinary() {
+
+        if (model->backgroundReaders > 0) {
+            wxLogError("Wait for the export to finish first");
+            return;
+        }
+
+        // ring rows go into items, which a file backed model doesn't use
+        if (ringFeed.isRunning()) {
+            stopRing("Stopped receiving rows");
+        }
+
+        wxFileDialog dialog(this, "Open Binary Export", "", "", "Binary files (*.wxlb)|*.wxlb", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+
+        if (dialog.ShowModal() != wxID_OK) {
+            return;
+        }
+
+        wxString error;
+        auto file = ItemFile::open(dialog.GetPath(), error);
+
+        if (!file) {
+            wxLogError("%s", error);
+            return;
+        }
+
+        model->attachSource(std::move(file));
+        listView->RefreshAfterUpdate();
+
+        GetMenuBar()->Check(ID_COMPRESS_TEXT, false);
+        watchFile(wxString());
+
+        SetStatusText(wxString::Format("%zu rows from %s", model->totalRows(), dialog.GetPath()));
+    }
+
+    // Load a binary export into memory and watch it - when the file changes
+    // the rows are patched in place (see reload)
+    void loadBinary() {
+
+        if (model->backgroundReaders > 0) {
+            wxLogError("Wait for the export to finish first");
+            return;
+        }
+
+        wxFileDialog dialog(this, "Load Binary Export", "", "", "Binary files (*.wxlb)|*.wxlb", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+
+        if (dialog.ShowModal() != wxID_OK) {
+            return;
+        }
+
+        wxString error;
+        auto file = ItemFile::open(dialog.GetPath(), error);
+
+        if (!file) {
+            wxLogError("%s", error);
+            return;
+        }
+
+        wxBusyCursor busy;
+
+        model->attachSource(nullptr);
+        model->items = file->readAll();
+        model->rowsChanged();
+        listView->RefreshAfterUpdate();
+
+        GetMenuBar()->Check(ID_COMPRESS_TEXT, false);
+        watchFile(dialog.GetPath());
+
+        SetStatusText(wxString::Format("%zu rows loaded from %s", model->totalRows(), dialog.GetPath()));
+    }
+
+    // Start watching path for changes (empty path stops watching)
+    void watchFile(const wxString& path) {
+
+        loadedPath = path;
+        reloadTimer.Stop();
+        GetMenuBar()->Enable(ID_RELOAD, !path.IsEmpty());
+
+        if (watcher) {
+            watcher->RemoveAll();
+        }
+
+        if (path.IsEmpty()) {
+            return;
+        }
+
+        if (!watcher) {
+
+            watcher = new wxFileSystemWatcher();
+            watcher->SetOwner(this);
+
+            Bind(wxEVT_FSWATCHER, [this](wxFileSystemWatcherEvent& event) {
+
+                // the directory is watched (writers often replace the file)
+                if (event.GetPath().GetFullPath() == loadedPath || event.GetNewPath().GetFullPath() == loadedPath) {
+                    reloadTimer.StartOnce(500);
+                }
+                });
+        }
+
+        watcher->Add(wxFileName::DirName(wxFileName(path).GetPath()), wxFSW_EVENT_CREATE | wxFSW_EVENT_MODIFY | wxFSW_EVENT_RENAME);
+    }
+
+    // Re-read the loaded file and apply only the differences, keeping the
+    // selection and the row at the top of the list where the user left them
+    void reload() {
+
+        if (loadedPath.IsEmpty()) {
+            return;
+        }
+
+        if (model->backgroundReaders > 0) {
+
+            // try again once the export has finished
+            reloadTimer.StartOnce(500);
+            return;
+        }
+
+        wxString error;
+        auto file = ItemFile::open(loadedPath, error);
+
+        if (!file) {
+            SetStatusText(error);
+            return;
+        }
+
+        wxStopWatch timer;
+
+        vector<ItemData> fresh = file->readAll();
+        file.reset();
+
+        auto state = listView->saveViewState();
+
+        // rows were compressed since - plain rows are needed to patch
+        if (model->source) {
+            model->loadIntoMemory();
+            GetMenuBar()->Check(ID_COMPRESS_TEXT, false);
+        }
+
+        auto result = model->applyUpdate(fresh);
+        listView->restoreViewState(state, result.changedRows);
+
+        SetStatusText(wxString::Format("Reloaded: %zu inserted, %zu deleted, %zu updated (%ldms)",
+            result.inserted, result.deleted, result.updated, timer.Time()));
+    }
+
+    // Create a shared memory ring and append whatever rows an ingest
+    // process (e.g. wx3-list-ingest) writes to it
+    void listenOnRing() {
+
+        if (ringFeed.isRunning()) {
+            return;
+        }
+
+        wxString name = wxGetTextFromUser("Ring name (run the ingest process with the same name)", "Receive Rows", "rows", this);
+
+        if (name.IsEmpty()) {
+            return;
+        }
+
+        // loading into memory frees the block cache export etc. read from
+        if (model->backgroundReaders > 0) {
+            wxLogError("Wait for the export to finish first");
+            return;
+        }
+
+        // the model has to be in memory, like reload
+        model->loadIntoMemory();
+
+        wxString error;
+        ringRows = 0;
+
+        bool started = ringFeed.start(*model, name, this,
+            [this](size_t rows, bool closed) {
+
+                ringRows += rows;
+                listView->RefreshAfterUpdate();
+
+                if (closed) {
+                    stopRing(wxString::Format("Ingest finished - %zu rows received", ringRows));
+                }
+                else {
+                    SetStatusText(wxString::Format("Receiving rows on '%s'... %zu so far", ringFeed.ringName(), ringRows));
+                }
+            },
+            error);
+
+        if (!started) {
+            wxLogError("Could not receive rows: %s", error);
+            return;
+        }
+
+        GetMenuBar()->Enable(ID_LISTEN_RING, false);
+        GetMenuBar()->Enable(ID_STOP_RING, true);
+        SetStatusText(wxString::Format("Waiting for rows on '%s'", name));
+    }
+
+    void stopRing(const wxString& message) {
+
+        ringFeed.stop();
+
+        GetMenuBar()->Enable(ID_LISTEN_RING, true);
+        GetMenuBar()->Enable(ID_STOP_RING, false);
+        SetStatusText(message);
+    }
+
+    // Reconcile the current rows with a binary export by id and show the
+    // differences in a new window (current rows are the older side)
+    void compareWithBinary() {
+
+        if (merger.isRunning()) {
+            SetStatusText("A compare is already running");
+            return;
+        }
+
+        wxFileDialog dialog(this, "Compare With Binary Export", "", "", "Binary files (*.wxlb)|*.wxlb", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+
+        if (dialog.ShowModal() != wxID_OK) {
+            return;
+        }
+
+        wxString error;
+        auto file = ItemFile::open(dialog.GetPath(), error);
+
+        if (!file) {
+            wxLogError("%s", error);
+            return;
+        }
+
+        auto other = std::make_shared<ListModel>();
+        other->attachSource(std::move(file));
+
+        wxString title = "Compare with " + dialog.GetPath();
+
+        merger.start(*model, other, this, [this, title](std::shared_ptr<MergeResult> merged) {
+
+            SetStatusText(wxString::Format("Compared: %zu added, %zu removed, %zu changed", merged->added, merged->removed, merged->changed));
+
+            auto compare = new CompareFrame(this, title, std::move(*merged));
+            compare->Show();
+            });
+
+        SetStatusText("Comparing...");
+    }
+
+    // Trade some CPU for memory - keep name/description LZ compressed in
+    // blocks, decoded through the model's block cache as the list needs them
+    void compressText(bool compress) {
+
+        if (model->backgroundReaders > 0) {
+            wxLogError("Wait for the export to finish first");
+            GetMenuBar()->Check(ID_COMPRESS_TEXT, !compress);
+            return;
+        }
+
+        // ring rows go into items, which a compressed model doesn't read
+        if (compress && ringFeed.isRunning()) {
+            wxLogError("Stop receiving rows before compressing");
+            GetMenuBar()->Check(ID_COMPRESS_TEXT, false);
+            return;
+        }
+
+        wxBusyCursor busy;
+
+        // from a file or already compressed - start from plain rows
+        model->loadIntoMemory();
+
+        if (compress) {
+
+            auto compressed = CompressedRows::build(model->items);
+
+            SetStatusText(wxString::Format("Text columns compressed: %.1f MB -> %.1f MB",
+                compressed->textBytes() / 1048576.0, compressed->compressedBytes() / 1048576.0));
+
+            model->attachSource(std::move(compressed));
+        }
+        else {
+
+            SetStatusText("Text columns uncompressed");
+        }
+
+        listView->RefreshAfterUpdate();
+    }
+
+    // Copy the selected rows (tab separated) - serialized in the background
+    // so even millions of rows don't stall the UI
+    void copySelection() {
+
+        if (copier.isRunning()) {
+            return;
+        }
+
+        vector<size_t> rows;
+        ClipboardCopier::Ranges ranges;
+        listView->selectionSnapshot(rows, ranges);
+
+        if (ranges.empty()) {
+            return;
+        }
+
+        copier.start(*model, std::move(rows), std::move(ranges), this,
+            [this](size_t done, size_t total) {
+                SetStatusText(wxString::Format("Copying... %zu / %zu rows", done, total));
+            },
+            [this](bool ok, const wxString& message) {
+                SetStatusText(message);
+                GetMenuBar()->Enable(ID_COPY_CANCEL, false);
+            });
+
+        GetMenuBar()->Enable(ID_COPY_CANCEL, true);
+        SetStatusText("Copying...");
+    }
+
+    // Write the current (sorted/filtered) view to a file in the background
+    void exportView(ExportFormat format) {
+
+        if (exporter.isRunning()) {
+            return;
+        }
+
+        auto wildcard = (format == ExportFormat::CSV) ? "CSV files (*.csv)|*.csv" : "Binary files (*.wxlb)|*.wxlb";
+
+        wxFileDialog dialog(this, "Export View", "", "", wildcard, wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+        if (dialog.ShowModal() != wxID_OK) {
+            return;
+        }
+
+        wxStopWatch* timer = new wxStopWatch();
+
+        bool started = exporter.start(*model, dialog.GetPath(), format, this,
+            [this](size_t done, size_t total) {
+                SetStatusText(wxString::Format("Exporting... %zu / %zu rows", done, total));
+            },
+            [this, timer](bool ok, const wxString& message) {
+                SetStatusText(wxString::Format("%s (%.2fs)", message, timer->Time() / 1000.0));
+                GetMenuBar()->Enable(ID_EXPORT_CANCEL, false);
+                delete timer;
+            });
+
+        if (!started) {
+            delete timer;
+            wxLogError("Could not create %s", dialog.GetPath());
+            return;
+        }
+
+        GetMenuBar()->Enable(ID_EXPORT_CANCEL, true);
+        SetStatusText("Exporting...");
+    }
 };
 
 // Main app class declaration
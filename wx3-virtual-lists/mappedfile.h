@@ -0,0 +1,151 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <algorithm>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+
+public:
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+
+        close();
+    }
+
+    bool open(const wxString& path) {
+
+        close();
+
+#ifdef _WIN32
+        file = CreateFileW(path.wc_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+
+        if (!GetFileSizeEx(file, &fileSize)) {
+            close();
+            return false;
+        }
+
+        length = static_cast<size_t>(fileSize.QuadPart);
+
+        if (length > 0) {
+
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+            if (mapping == nullptr) {
+                close();
+                return false;
+            }
+
+            bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+#else
+        int fd = ::open(path.fn_str(), O_RDONLY);
+
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat info;
+
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        length = static_cast<size_t>(info.st_size);
+
+        if (length > 0) {
+
+            void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            bytes = (p == MAP_FAILED) ? nullptr : static_cast<const char*>(p);
+        }
+
+        ::close(fd); // the mapping keeps the file open
+#endif
+
+        if (length > 0 && bytes == nullptr) {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void close() {
+
+#ifdef _WIN32
+        if (bytes) {
+            UnmapViewOfFile(bytes);
+        }
+
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (bytes) {
+            munmap(const_cast<char*>(bytes), length);
+        }
+#endif
+
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+    // Hint that a byte range will be read soon (no-op where unsupported)
+    void willNeed(size_t offset, size_t count) const {
+
+#ifndef _WIN32
+        if (!bytes || offset >= length) {
+            return;
+        }
+
+        // madvise wants a page aligned start
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t start = offset & ~(page - 1);
+        count = std::min(count + (offset - start), length - start);
+
+        madvise(const_cast<char*>(bytes + start), count, MADV_WILLNEED);
+#endif
+    }
+
+private:
+
+    const char* bytes{ nullptr };
+    size_t length{ 0 };
+
+#ifdef _WIN32
+    HANDLE file{ INVALID_HANDLE_VALUE };
+    HANDLE mapping{ nullptr };
+#endif
+};
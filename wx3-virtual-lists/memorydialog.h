@@ -0,0 +1,98 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+#include <functional>
+#include <algorithm>
+
+#include "memoryusage.h"
+
+
+// Debug panel listing MemoryUsage items, largest first, with a total and
+// CSV export.  collect is called again on Refresh.
+class MemoryDialog : public wxDialog {
+
+public:
+
+    MemoryDialog(wxWindow* parent, std::function<MemoryUsage()> collect) :
+        wxDialog(parent, wxID_ANY, "Memory Usage", wxDefaultPosition, wxSize(640, 480), wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER), collect(collect) {
+
+        auto sizer = new wxBoxSizer(wxVERTICAL);
+
+        list = new wxListView(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT);
+        list->AppendColumn("Category");
+        list->AppendColumn("Name");
+        list->AppendColumn("Bytes", wxLIST_FORMAT_RIGHT);
+        list->AppendColumn("MB", wxLIST_FORMAT_RIGHT);
+
+        list->SetColumnWidth(0, 80);
+        list->SetColumnWidth(1, 320);
+        list->SetColumnWidth(2, 100);
+        list->SetColumnWidth(3, 80);
+
+        sizer->Add(list, 1, wxALL | wxEXPAND, 4);
+
+        totalText = new wxStaticText(this, wxID_ANY, "");
+        sizer->Add(totalText, 0, wxALL | wxEXPAND, 4);
+
+        auto buttons = new wxBoxSizer(wxHORIZONTAL);
+        auto refresh = new wxButton(this, wxID_REFRESH);
+        auto exportCsv = new wxButton(this, wxID_SAVEAS, "Export CSV...");
+        auto close = new wxButton(this, wxID_CLOSE);
+
+        buttons->Add(refresh, 0, wxALL, 4);
+        buttons->Add(exportCsv, 0, wxALL, 4);
+        buttons->AddStretchSpacer();
+        buttons->Add(close, 0, wxALL, 4);
+
+        sizer->Add(buttons, 0, wxEXPAND);
+        SetSizer(sizer);
+
+        refresh->Bind(wxEVT_BUTTON, [this](wxCommandEvent& event) { this->update(); });
+        exportCsv->Bind(wxEVT_BUTTON, [this](wxCommandEvent& event) { this->exportUsage(); });
+        close->Bind(wxEVT_BUTTON, [this](wxCommandEvent& event) { this->Close(); });
+
+        update();
+    }
+
+    void update() {
+
+        usage = collect();
+
+        std::vector<MemoryItem> rows = usage.items();
+        std::stable_sort(rows.begin(), rows.end(), [](const MemoryItem& a, const MemoryItem& b) { return a.bytes > b.bytes; });
+
+        list->DeleteAllItems();
+
+        for (size_t i = 0; i < rows.size(); i++) {
+
+            long index = list->InsertItem(static_cast<long>(i), rows[i].category);
+            list->SetItem(index, 1, rows[i].name);
+            list->SetItem(index, 2, wxString::Format("%zu", rows[i].bytes));
+            list->SetItem(index, 3, wxString::Format("%.2f", rows[i].bytes / 1048576.0));
+        }
+
+        totalText->SetLabel(wxString::Format("Total (excluding Arena): %.2f MB", usage.total() / 1048576.0));
+    }
+
+private:
+
+    std::function<MemoryUsage()> collect;
+    MemoryUsage usage;
+
+    wxListView* list{ nullptr };
+    wxStaticText* totalText{ nullptr };
+
+    void exportUsage() {
+
+        wxFileDialog dialog(this, "Export Memory Usage", "", "memory.csv", "CSV files (*.csv)|*.csv", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+        if (dialog.ShowModal() != wxID_OK) {
+            return;
+        }
+
+        if (!usage.writeCsv(dialog.GetPath())) {
+            wxLogError("Could not write %s", dialog.GetPath());
+        }
+    }
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#include <malloc.h>
+#define HAVE_MALLINFO2
+#endif
+
+#ifdef __WXMSW__
+#include <wx/msw/wrapwin.h>
+#include <psapi.h>
+#endif
+
+
+// Bytes used by one part of a model or view
+struct MemoryItem {
+
+    wxString    category;   // Column, Index, Cache, Storage or Arena
+    wxString    name;
+    size_t      bytes{ 0 };
+};
+
+
+// Memory accounting - models, sources and views add what they hold.
+// Figures are estimates of heap bytes (capacity, not size, so vector slack
+// shows up) including a per-allocation allocator header; the Arena
+// category is the allocator's own view of the whole process and overlaps
+// everything else, so it isn't part of total().
+class MemoryUsage {
+
+public:
+
+    // Rough bookkeeping cost of one heap block
+    static constexpr size_t AllocationOverhead = 2 * sizeof(void*);
+
+    void add(const wxString& category, const wxString& name, size_t bytes) {
+
+        entries.push_back({ category, name, bytes });
+    }
+
+    const std::vector<MemoryItem>& items() const { return entries; }
+
+    // Everything except Arena
+    size_t total() const {
+
+        size_t sum = 0;
+
+        for (auto& entry : entries) {
+            if (entry.category != "Arena") {
+                sum += entry.bytes;
+            }
+        }
+
+        return sum;
+    }
+
+    template<typename T>
+    static size_t vectorBytes(const std::vector<T>& v) {
+
+        return v.capacity() ? v.capacity() * sizeof(T) + AllocationOverhead : 0;
+    }
+
+    // Heap bytes behind a wxString (not the wxString itself).  Short
+    // strings live inside the object; longer ones have a buffer of
+    // capacity + 1 characters.
+    static size_t stringHeapBytes(const wxString& s) {
+
+        static const size_t inlineCapacity = wxString().capacity();
+
+        size_t capacity = s.capacity();
+        return (capacity > inlineCapacity) ? (capacity + 1) * sizeof(wxStringCharType) + AllocationOverhead : 0;
+    }
+
+    // What the C runtime's allocator reports for the process (glibc
+    // mallinfo2, or the Windows process heap and process counters)
+    void addProcessHeap() {
+
+#ifdef HAVE_MALLINFO2
+        struct mallinfo2 info = mallinfo2();
+
+        add("Arena", "malloc: in use", info.uordblks);
+        add("Arena", "malloc: free in arenas (fragmentation)", info.fordblks);
+        add("Arena", "malloc: large blocks (mmap)", info.hblkhd);
+#endif
+
+#ifdef __WXMSW__
+        // the CRT's malloc allocates from the process heap
+        HEAP_SUMMARY heap{};
+        heap.cb = sizeof(heap);
+
+        if (HeapSummary(GetProcessHeap(), 0, &heap)) {
+            add("Arena", "process heap: in use", heap.cbAllocated);
+            add("Arena", "process heap: committed, not in use (fragmentation)", heap.cbCommitted > heap.cbAllocated ? heap.cbCommitted - heap.cbAllocated : 0);
+        }
+
+        PROCESS_MEMORY_COUNTERS_EX counters{};
+        counters.cb = sizeof(counters);
+
+        if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters))) {
+            add("Arena", "process: private bytes", counters.PrivateUsage);
+            add("Arena", "process: working set", counters.WorkingSetSize);
+        }
+#endif
+    }
+
+    // category,name,bytes - one line per item plus the total
+    bool writeCsv(const wxString& path) const {
+
+        std::FILE* file = wxFopen(path, "wb");
+
+        if (!file) {
+            return false;
+        }
+
+        std::string text = "category,name,bytes\n";
+
+        for (auto& entry : entries) {
+
+            wxString name = entry.name;
+            name.Replace("\"", "\"\"");
+
+            text += std::string(entry.category.utf8_str()) + ",\"" + std::string(name.utf8_str()) + "\"," + std::to_string(entry.bytes) + "\n";
+        }
+
+        text += "Total,\"\"," + std::to_string(total()) + "\n";
+
+        bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+        return (std::fclose(file) == 0) && ok;
+    }
+
+private:
+
+    std::vector<MemoryItem> entries;
+};
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+#include "listmodel.h"
+#include "workerpool.h"
+
+
+// How a row in a merged model relates to the two inputs
+enum class RowChange : uint8_t {
+
+    Same,       // id on both sides, same name/description
+    Changed,    // id on both sides, name or description differs
+    Added,      // id only in the newer model
+    Removed     // id only in the older model
+};
+
+
+struct MergeResult {
+
+    std::vector<ItemData> rows;
+    std::vector<RowChange> changes;     // parallel to rows
+
+    size_t added{ 0 };
+    size_t removed{ 0 };
+    size_t changed{ 0 };
+};
+
+
+// Reconcile two models by id.  A hash table is built on the smaller model
+// and the larger one is streamed through it once, in contiguous chunks
+// shared out over the worker pool - each row of it is read (and, from a
+// file, decoded) by exactly one thread.  A build row is claimed by the
+// first probe row to match it with an atomic exchange on its "was matched"
+// flag.  Rows present on both sides come from newer.  Duplicate ids: only
+// one row with an id is matched (which one, when the probe side has
+// duplicates in different chunks, depends on timing).
+inline MergeResult mergeById(const ListModel& older, const ListModel& newer) {
+
+    bool buildOnOlder = older.totalRows() <= newer.totalRows();
+    const ListModel& build = buildOnOlder ? older : newer;
+    const ListModel& probe = buildOnOlder ? newer : older;
+
+    size_t buildRows = build.totalRows();
+    size_t probeRows = probe.totalRows();
+
+    std::unordered_map<int, size_t> index;
+    index.reserve(buildRows);
+
+    {
+        RowCursor rows(build);
+
+        for (size_t r = 0; r < buildRows; r++) {
+            index.emplace(rows[r].id, r);
+        }
+    }
+
+    // block sized chunks, so a file backed side is decoded block by block
+    const size_t ChunkRows = 16 * RowSource::BlockRows;
+
+    size_t chunks = (probeRows + ChunkRows - 1) / ChunkRows;
+    std::vector<std::atomic<uint8_t>> matched(buildRows);
+    std::vector<MergeResult> partial(chunks);
+    std::atomic<size_t> next{ 0 };
+
+    WorkerPool::shared().run(std::max<size_t>(chunks, 1) - 1, [&]() {
+
+        RowCursor probeRowsAt(probe);
+        RowCursor buildRowsAt(build);
+
+        for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+
+            MergeResult& out = partial[chunk];
+            size_t end = std::min(probeRows, (chunk + 1) * ChunkRows);
+
+            for (size_t r = chunk * ChunkRows; r < end; r++) {
+
+                const ItemData& item = probeRowsAt[r];
+                auto found = index.find(item.id);
+
+                if (found == index.end() || matched[found->second].exchange(1)) {
+
+                    // only on the probe side
+                    out.rows.push_back(item);
+                    out.changes.push_back(buildOnOlder ? RowChange::Added : RowChange::Removed);
+                    continue;
+                }
+
+                const ItemData& other = buildRowsAt[found->second];
+                bool same = other.name == item.name && other.description == item.description;
+
+                out.rows.push_back(buildOnOlder ? item : other);
+                out.changes.push_back(same ? RowChange::Same : RowChange::Changed);
+            }
+        }
+        });
+
+    // Stitch the chunks together (probe order), then the unmatched build rows
+    MergeResult result;
+
+    size_t total = 0;
+
+    for (auto& part : partial) {
+        total += part.rows.size();
+    }
+
+    result.rows.reserve(total + buildRows);
+    result.changes.reserve(total + buildRows);
+
+    for (auto& part : partial) {
+
+        std::move(part.rows.begin(), part.rows.end(), std::back_inserter(result.rows));
+        result.changes.insert(result.changes.end(), part.changes.begin(), part.changes.end());
+    }
+
+    RowCursor rows(build);
+
+    for (size_t r = 0; r < buildRows; r++) {
+
+        if (!matched[r]) {
+            result.rows.push_back(rows[r]);
+            result.changes.push_back(buildOnOlder ? RowChange::Removed : RowChange::Added);
+        }
+    }
+
+    for (RowChange change : result.changes) {
+
+        result.added += (change == RowChange::Added);
+        result.removed += (change == RowChange::Removed);
+        result.changed += (change == RowChange::Changed);
+    }
+
+    return result;
+}
+
+
+// Runs mergeById on a worker thread.  The current model is registered as
+// being read until the result has been delivered (on the UI thread, via
+// notify->CallAfter).
+class ModelMerger {
+
+public:
+
+    using DoneCallback = std::function<void(std::shared_ptr<MergeResult> result)>;
+
+    ~ModelMerger() {
+
+        join();
+    }
+
+    bool isRunning() const { return running; }
+
+    // other is kept alive until the merge is done
+    bool start(ListModel& model, std::shared_ptr<ListModel> other, wxEvtHandler* notify, DoneCallback onDone) {
+
+        if (running) {
+            return false;
+        }
+
+        join();
+
+        running = true;
+        model.backgroundReaders++;
+
+        worker = std::thread([this, &model, other, notify, onDone]() {
+
+            auto result = std::make_shared<MergeResult>(mergeById(model, *other));
+
+            running = false;
+
+            notify->CallAfter([&model, other, onDone, result]() {
+
+                model.backgroundReaders--;
+                onDone(result);
+                });
+            });
+
+        return true;
+    }
+
+private:
+
+    std::thread worker;
+    std::atomic<bool> running{ false };
+
+    void join() {
+
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+};
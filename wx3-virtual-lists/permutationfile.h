@@ -0,0 +1,98 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <wx/filefn.h>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+
+#include "mappedfile.h"
+
+
+// Sorted order written by ExternalSorter - header, then the model row
+// (uint64, host byte order) for each view position
+struct PermutationFileHeader {
+
+    char        magic[4]{ 'W', 'X', 'L', 'P' };
+    uint32_t    formatVersion{ 1 };
+    uint64_t    rowCount{ 0 };
+};
+
+
+// A permutation file mapped read-only - the model's view when a file
+// backed model has been sorted on disk (see ListModel::useSortedView).
+// Positions are read straight from the mapping, so the OS pages the
+// order in and out like the rows themselves.
+class MappedPermutation {
+
+public:
+
+    MappedPermutation(const MappedPermutation&) = delete;
+    MappedPermutation& operator=(const MappedPermutation&) = delete;
+
+    ~MappedPermutation() {
+
+        file.close();
+
+        if (removeOnClose) {
+            wxRemoveFile(path);
+        }
+    }
+
+    // nullptr (and error set) if path isn't a complete permutation file.
+    // A temporary file can be removed when the permutation is dropped.
+    static std::shared_ptr<MappedPermutation> open(const wxString& path, bool removeOnClose, wxString& error) {
+
+        std::shared_ptr<MappedPermutation> permutation(new MappedPermutation());
+        permutation->path = path;
+
+        if (!permutation->file.open(path)) {
+            error = wxString::Format("Could not open %s", path);
+            return nullptr;
+        }
+
+        PermutationFileHeader header;
+        size_t size = permutation->file.size();
+
+        if (size < sizeof(header)) {
+            error = "Sort order file is truncated";
+            return nullptr;
+        }
+
+        std::memcpy(&header, permutation->file.data(), sizeof(header));
+
+        if (std::memcmp(header.magic, "WXLP", 4) != 0 || header.formatVersion != 1
+            || size != sizeof(header) + header.rowCount * sizeof(uint64_t)) {
+            error = "Not a sort order file";
+            return nullptr;
+        }
+
+        permutation->count = static_cast<size_t>(header.rowCount);
+        permutation->removeOnClose = removeOnClose;
+        return permutation;
+    }
+
+    size_t size() const { return count; }
+
+    size_t operator[](size_t position) const {
+
+        uint64_t row;
+        std::memcpy(&row, file.data() + sizeof(PermutationFileHeader) + position * sizeof(row), sizeof(row));
+        return static_cast<size_t>(row);
+    }
+
+    // Hint that positions [first, first + n) will be read soon
+    void willNeed(size_t first, size_t n) const {
+
+        file.willNeed(sizeof(PermutationFileHeader) + first * sizeof(uint64_t), n * sizeof(uint64_t));
+    }
+
+private:
+
+    MappedFile file;
+    wxString path;
+    size_t count{ 0 };
+    bool removeOnClose{ false };
+
+    MappedPermutation() = default;
+};
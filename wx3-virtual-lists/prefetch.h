@@ -0,0 +1,101 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <memory>
+
+#include "rowsource.h"
+
+
+// Decodes blocks into a BlockCache on a worker thread.  Only the latest
+// request matters - a new request replaces whatever hasn't been decoded
+// yet, so scrolling past a region doesn't leave a backlog behind it.
+class BlockPrefetcher {
+
+public:
+
+    BlockPrefetcher(const RowSource& source, BlockCache& cache) : source(source), cache(cache) {
+
+        worker = std::thread([this]() { run(); });
+    }
+
+    ~BlockPrefetcher() {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wake.notify_one();
+        worker.join();
+    }
+
+    // Blocks in priority order (hinted range first, then readahead)
+    void request(std::vector<size_t> blocks) {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = std::move(blocks);
+            generation++;
+        }
+
+        wake.notify_one();
+    }
+
+private:
+
+    const RowSource& source;
+    BlockCache& cache;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    std::vector<size_t> pending;
+    uint64_t generation{ 0 };
+    bool stopping{ false };
+
+    void run() {
+
+        std::vector<size_t> blocks;
+
+        while (true) {
+
+            uint64_t working;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || !pending.empty(); });
+
+                if (stopping) {
+                    return;
+                }
+
+                blocks.swap(pending);
+                pending.clear();
+                working = generation;
+            }
+
+            for (size_t block : blocks) {
+
+                // a newer request supersedes the rest of this one
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    if (stopping || generation != working) {
+                        break;
+                    }
+                }
+
+                if (!cache.contains(block)) {
+
+                    auto rows = std::make_shared<std::vector<ItemData>>();
+                    source.decodeBlock(block, *rows);
+                    cache.insert(block, rows);
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#include "listmodel.h"
+#include "filterquery.h"
+#include "workerpool.h"
+
+
+// How far a progressive query has got
+struct QueryProgress {
+
+    size_t  scannedRows{ 0 };
+    size_t  totalRows{ 0 };
+    size_t  matchedRows{ 0 };   // exact, among the scanned rows
+
+    // Estimated matches in the whole model with a 95% confidence interval
+    // (all equal to matchedRows once complete)
+    double  estimate{ 0 };
+    double  low{ 0 };
+    double  high{ 0 };
+
+    bool    complete{ false };
+};
+
+
+// Runs a FilterQuery over a large model in the background, publishing the
+// matches found so far and an estimate of the final count as it goes.
+// Rows are scanned in chunks visited in random order, so every interim
+// result is a uniform sample of the model: the count estimate is a
+// cluster sample ratio estimate whose interval tightens as chunks come in,
+// and the rows revealed so far are spread over the whole model rather than
+// bunched at the top.  Chunks are evaluated on all cores (WorkerPool);
+// each interim result carries only the rows found since the previous one,
+// so publishing costs what is new rather than everything found so far.
+// Callbacks are delivered on the UI thread via notify->CallAfter.
+class ProgressiveQuery {
+
+public:
+
+    // Matched model rows - the callback may move them out
+    using Rows = std::shared_ptr<std::vector<size_t>>;
+
+    // rows are the matches found since the previous progress callback
+    // (grouped by chunk, chunks in no particular order)
+    using ProgressCallback = std::function<void(const QueryProgress& progress, Rows rows)>;
+
+    // rows is the exact result in model order (or, if cancelled, what had
+    // been found)
+    using DoneCallback = std::function<void(const QueryProgress& progress, Rows rows, bool cancelled)>;
+
+    // Smaller models are queried in one go
+    static constexpr size_t MinRows = 1000 * 1000;
+
+    // Rows per chunk (a multiple of 64) and time between interim results
+    static constexpr size_t ChunkRows = 16 * 1024;
+    static constexpr int PublishMilliseconds = 250;
+
+    ~ProgressiveQuery() {
+
+        cancel();
+    }
+
+    bool isRunning() const { return running; }
+
+    // Replaces a query that is still running (see discard)
+    void start(ListModel& model, std::shared_ptr<const FilterQuery> query,
+        wxEvtHandler* notify, ProgressCallback onProgress, DoneCallback onDone) {
+
+        discard();
+
+        cancelled = false;
+        running = true;
+        model.backgroundReaders++;
+
+        uint64_t run = ++generation;
+
+        worker = std::thread([this, &model, query, run, notify, onProgress, onDone]() {
+
+            auto publish = [this, run, notify, onProgress](const QueryProgress& progress, Rows rows) {
+                notify->CallAfter([this, run, onProgress, progress, rows]() {
+                    if (run == generation) {
+                        onProgress(progress, rows);
+                    }
+                    });
+                };
+
+            Rows rows;
+            QueryProgress progress = scan(model, *query, publish, rows);
+
+            bool stopped = cancelled;
+
+            // the rows stay registered as read until the last callback has
+            // run (even for a discarded query) - results hold model rows,
+            // which a drain or reload in between would renumber
+            notify->CallAfter([this, &model, run, onDone, progress, rows, stopped]() {
+
+                model.backgroundReaders--;
+
+                if (run == generation) {
+                    running = false;
+                    onDone(progress, rows, stopped);
+                }
+                });
+            });
+    }
+
+    // Stop a running query (waits for the worker to finish)
+    void cancel() {
+
+        cancelled = true;
+        join();
+    }
+
+    // Stop a running query without delivering anything more from it
+    void discard() {
+
+        generation++;
+        cancel();
+        running = false;
+    }
+
+private:
+
+    std::thread worker;
+    std::atomic<bool> running{ false };
+    std::atomic<bool> cancelled{ false };
+    std::atomic<uint64_t> generation{ 0 };
+
+    void join() {
+
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    // Chunk results shared by the scanning threads
+    struct Scan {
+
+        std::mutex mutex;
+        std::vector<size_t> finished;       // chunks, in completion order
+        std::vector<std::vector<size_t>> matches;
+        size_t scannedRows{ 0 };
+        size_t matchedRows{ 0 };
+    };
+
+    template<typename Publish>
+    QueryProgress scan(const ListModel& model, const FilterQuery& query, const Publish& publish, Rows& result) {
+
+        size_t total = model.totalRows();
+        size_t chunks = (total + ChunkRows - 1) / ChunkRows;
+
+        // random visiting order
+        std::vector<size_t> order(chunks);
+        std::iota(order.begin(), order.end(), size_t{ 0 });
+        std::shuffle(order.begin(), order.end(), std::mt19937_64(std::random_device()()));
+
+        Scan shared;
+        shared.matches.resize(chunks);
+
+        std::atomic<size_t> next{ 0 };
+
+        // the thread that started the scan publishes between its chunks
+        std::thread::id publisher = std::this_thread::get_id();
+        auto publishAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(PublishMilliseconds);
+        size_t published = 0;
+
+        std::function<void()> work = [&]() {
+
+            RowCursor rows(model);
+            std::vector<uint64_t> words(ChunkRows / 64);
+            std::vector<size_t> found;
+
+            bool publishing = std::this_thread::get_id() == publisher;
+
+            for (size_t i = next++; i < chunks && !cancelled; i = next++) {
+
+                size_t chunk = order[i];
+                size_t firstRow = chunk * ChunkRows;
+                size_t count = std::min(total, firstRow + ChunkRows) - firstRow;
+
+                // ids come through the cursor chunk by chunk - building the
+                // model's id column first would read every row before the
+                // first answer
+                query.evaluateRange(rows, nullptr, firstRow, count, words.data());
+
+                found.clear();
+
+                for (size_t w = 0; w < (count + 63) / 64; w++) {
+                    for (uint64_t bits = words[w]; bits; bits &= bits - 1) {
+                        found.push_back(firstRow + w * 64 + Query::ctz(bits));
+                    }
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(shared.mutex);
+
+                    shared.matches[chunk] = found;
+                    shared.finished.push_back(chunk);
+                    shared.scannedRows += count;
+                    shared.matchedRows += found.size();
+                }
+
+                if (publishing && std::chrono::steady_clock::now() >= publishAt) {
+
+                    publishAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(PublishMilliseconds);
+                    publish(progressOf(shared, total, chunks), collect(shared, published));
+                }
+            }
+            };
+
+        WorkerPool::shared().run(std::max<size_t>(chunks, 1) - 1, work);
+
+        QueryProgress progress = progressOf(shared, total, chunks);
+
+        size_t all = 0;
+        result = collect(shared, all, true);
+
+        return progress;
+    }
+
+    // Matches of the chunks finished from the from'th on (in completion
+    // order, or model order) - from moves past them
+    static Rows collect(Scan& shared, size_t& from, bool modelOrder = false) {
+
+        std::vector<size_t> chunks;
+        {
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            chunks.assign(shared.finished.begin() + from, shared.finished.end());
+            from = shared.finished.size();
+        }
+
+        if (modelOrder) {
+            std::sort(chunks.begin(), chunks.end());
+        }
+
+        size_t count = 0;
+
+        for (size_t chunk : chunks) {
+            count += shared.matches[chunk].size();
+        }
+
+        auto rows = std::make_shared<std::vector<size_t>>();
+        rows->reserve(count);
+
+        for (size_t chunk : chunks) {
+            rows->insert(rows->end(), shared.matches[chunk].begin(), shared.matches[chunk].end());
+        }
+
+        return rows;
+    }
+
+    // Ratio estimate of the total from the chunks seen so far.  Chunks are
+    // the sampling unit (rows within one are correlated); the variance is
+    // that of a ratio estimator under simple random sampling of chunks
+    // without replacement.
+    static QueryProgress progressOf(Scan& shared, size_t total, size_t chunks) {
+
+        std::lock_guard<std::mutex> lock(shared.mutex);
+
+        QueryProgress progress;
+        progress.totalRows = total;
+        progress.scannedRows = shared.scannedRows;
+        progress.matchedRows = shared.matchedRows;
+        progress.complete = (shared.finished.size() == chunks);
+
+        double unscanned = static_cast<double>(total - shared.scannedRows);
+        size_t n = shared.finished.size();
+
+        progress.low = static_cast<double>(shared.matchedRows);
+        progress.high = progress.low + unscanned;
+
+        if (progress.complete || n == 0) {
+            progress.estimate = progress.complete ? progress.low : (progress.low + progress.high) / 2;
+            return progress;
+        }
+
+        double ratio = progress.low / static_cast<double>(shared.scannedRows);
+        progress.estimate = ratio * static_cast<double>(total);
+
+        if (n < 2) {
+            return progress;
+        }
+
+        double sum = 0;
+
+        for (size_t chunk : shared.finished) {
+
+            double size = static_cast<double>(std::min(total, (chunk + 1) * ChunkRows) - chunk * ChunkRows);
+            double residual = static_cast<double>(shared.matches[chunk].size()) - ratio * size;
+            sum += residual * residual;
+        }
+
+        double meanSize = static_cast<double>(shared.scannedRows) / static_cast<double>(n);
+        double fpc = 1.0 - static_cast<double>(n) / static_cast<double>(chunks);
+        double ratioError = std::sqrt(fpc * sum / static_cast<double>(n - 1) / static_cast<double>(n)) / meanSize;
+        double margin = 1.96 * ratioError * static_cast<double>(total);
+
+        // never outside what is already certain
+        progress.low = std::max(progress.low, progress.estimate - margin);
+        progress.high = std::min(progress.high, progress.estimate + margin);
+
+        return progress;
+    }
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <algorithm>
+
+#include "listmodel.h"
+#include "sharedring.h"
+
+
+// Appends rows arriving through a SharedRing to an in-memory model.  A
+// watcher thread sleeps on the ring's data signal and posts one drain to
+// the UI thread (CallAfter) whenever rows are waiting; the drain decodes
+// records straight from the shared slots into items, hands the slots
+// back and adds the rows to the view.  While a drain is queued the
+// watcher waits for it, and each drain takes at most DrainBudget rows, so
+// a fast producer neither floods the event loop nor starves the UI - it
+// is held back by the ring filling up instead.
+class RingFeed {
+
+public:
+
+    // rows: appended by this drain; closed: the producer has finished
+    using RowsCallback = std::function<void(size_t rows, bool closed)>;
+
+    static constexpr size_t DrainBudget = 64 * 1024;
+
+    ~RingFeed() {
+
+        stop();
+    }
+
+    bool isRunning() const { return ring != nullptr; }
+
+    const wxString& ringName() const { return name; }
+
+    // Create the ring (named ringName) and start taking rows from it
+    bool start(ListModel& model, const wxString& ringName, wxEvtHandler* notify, RowsCallback onRows, wxString& error) {
+
+        if (model.source) {
+            error = "Rows from a ring are added in memory - load the file into memory first";
+            return false;
+        }
+
+        stop();
+
+        std::string ringError;
+        ring = SharedRing::create(std::string(ringName.utf8_str()), SharedRing::DefaultCapacity, ringError);
+
+        if (!ring) {
+            error = wxString::FromUTF8(ringError.c_str());
+            return false;
+        }
+
+        reader = std::make_unique<SharedRingReader>(*ring);
+        name = ringName;
+        stopping = false;
+        drainPending = false;
+
+        watcher = std::thread([this, &model, notify, onRows]() {
+
+            for (;;) {
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    drained.wait(lock, [this]() { return !drainPending || stopping; });
+
+                    if (stopping) {
+                        break;
+                    }
+                }
+
+                bool closed = reader->producerClosed();
+
+                if (reader->available() == 0 && !closed) {
+                    reader->waitForData(SharedRing::WaitMilliseconds);
+                    continue;
+                }
+
+                // rows can't be added under a running export etc
+                if (model.backgroundReaders > 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(SharedRing::WaitMilliseconds));
+                    continue;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    drainPending = true;
+                }
+
+                notify->CallAfter([this, &model, onRows]() {
+                    drain(model, onRows);
+                    });
+
+                if (closed && reader->available() == 0) {
+                    break;
+                }
+            }
+            });
+
+        return true;
+    }
+
+    // Stop taking rows and remove the ring (a producer still attached
+    // sees its writes go nowhere)
+    void stop() {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        drained.notify_one();
+
+        if (watcher.joinable()) {
+            watcher.join();
+        }
+
+        reader.reset();
+        ring.reset();
+    }
+
+private:
+
+    std::unique_ptr<SharedRing> ring;
+    std::unique_ptr<SharedRingReader> reader;
+    wxString name;
+
+    std::thread watcher;
+    std::mutex mutex;
+    std::condition_variable drained;
+    bool stopping{ false };
+    bool drainPending{ false };
+
+    // UI thread
+    void drain(ListModel& model, const RowsCallback& onRows) {
+
+        // stopped since this was queued
+        if (!reader) {
+            return;
+        }
+
+        // an export etc. started since the watcher looked - adding rows
+        // would move items under it, so leave them for the watcher to retry
+        if (model.backgroundReaders > 0 && reader->available() > 0) {
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                drainPending = false;
+            }
+
+            drained.notify_one();
+            return;
+        }
+
+        size_t count = static_cast<size_t>(std::min<uint64_t>(reader->available(), DrainBudget));
+        size_t first = model.items.size();
+
+        for (size_t i = 0; i < count; i++) {
+
+            const SharedRowRecord& record = reader->peek(i);
+
+            model.items.push_back({ record.id,
+                wxString::FromUTF8(record.name, std::min<size_t>(record.nameLength, SharedRowRecord::NameBytes)),
+                wxString::FromUTF8(record.description, std::min<size_t>(record.descriptionLength, SharedRowRecord::DescriptionBytes)) });
+        }
+
+        reader->release(count);
+
+        bool closed = reader->producerClosed() && reader->available() == 0;
+
+        if (count > 0) {
+            model.rowsAppended(first);
+        }
+
+        onRows(count, closed);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            drainPending = false;
+        }
+
+        drained.notify_one();
+    }
+};
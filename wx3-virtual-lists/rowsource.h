@@ -0,0 +1,226 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <atomic>
+#include <cstdint>
+
+#include "itemdata.h"
+#include "memoryusage.h"
+
+
+// Rows that live outside ListModel::items (in a file, compressed...) are
+// decoded a block of BlockRows consecutive rows at a time
+class RowSource {
+
+public:
+
+    static constexpr size_t BlockRows = 1024;
+
+    virtual ~RowSource() = default;
+
+    virtual size_t rowCount() const = 0;
+
+    // Decode rows [block * BlockRows, ...) into rows (may run on any thread)
+    virtual void decodeBlock(size_t block, std::vector<ItemData>& rows) const = 0;
+
+    // How many decoded blocks the model should cache
+    virtual size_t cacheBlocks() const { return 256; }
+
+    // Hint that blocks will be decoded soon (e.g. start the disk reads)
+    virtual void willNeed(size_t firstBlock, size_t lastBlock) const {}
+
+    // Add what the source holds (storage and indexes)
+    virtual void memoryUsage(MemoryUsage& usage) const {}
+
+    size_t blockCount() const { return (rowCount() + BlockRows - 1) / BlockRows; }
+};
+
+
+using RowBlock = std::shared_ptr<const std::vector<ItemData>>;
+
+
+// LRU cache of decoded blocks, shared by the UI thread and the prefetcher.
+// Blocks are handed out as shared_ptrs, so eviction never frees a block
+// somebody is still reading.
+class BlockCache {
+
+public:
+
+    BlockCache(const RowSource& source, size_t capacityBlocks) : source(source), capacity(capacityBlocks) {}
+
+    // Cached block or nullptr
+    RowBlock find(size_t block) {
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto found = blocks.find(block);
+
+        if (found == blocks.end()) {
+            return nullptr;
+        }
+
+        lru.splice(lru.begin(), lru, found->second.second);
+        return found->second.first;
+    }
+
+    bool contains(size_t block) const {
+
+        std::lock_guard<std::mutex> lock(mutex);
+        return blocks.count(block) != 0;
+    }
+
+    // Cached block, decoding it on this thread if it isn't cached yet
+    RowBlock get(size_t block) {
+
+        if (RowBlock cached = find(block)) {
+            return cached;
+        }
+
+        misses++;
+
+        // decode without holding the lock - the other thread may decode
+        // the same block meanwhile, in which case the first one in wins
+        auto rows = std::make_shared<std::vector<ItemData>>();
+        source.decodeBlock(block, *rows);
+
+        return insert(block, rows);
+    }
+
+    RowBlock insert(size_t block, RowBlock rows) {
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto found = blocks.find(block);
+
+        if (found != blocks.end()) {
+            return found->second.first;
+        }
+
+        lru.push_front(block);
+        blocks.emplace(block, std::make_pair(rows, lru.begin()));
+
+        while (blocks.size() > capacity) {
+            blocks.erase(lru.back());
+            lru.pop_back();
+        }
+
+        return rows;
+    }
+
+    void clear() {
+
+        std::lock_guard<std::mutex> lock(mutex);
+        blocks.clear();
+        lru.clear();
+    }
+
+    size_t size() const {
+
+        std::lock_guard<std::mutex> lock(mutex);
+        return blocks.size();
+    }
+
+    size_t capacityBlocks() const { return capacity; }
+
+    // Decoded rows held (including list/map bookkeeping)
+    size_t memoryBytes() const {
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        size_t bytes = 0;
+
+        for (auto& entry : blocks) {
+
+            const auto& rows = *entry.second.first;
+            bytes += MemoryUsage::vectorBytes(rows) + 4 * MemoryUsage::AllocationOverhead;
+
+            for (auto& row : rows) {
+                bytes += MemoryUsage::stringHeapBytes(row.name) + MemoryUsage::stringHeapBytes(row.description);
+            }
+        }
+
+        return bytes;
+    }
+
+    // Blocks that had to be decoded on the calling (usually UI) thread
+    size_t missCount() const { return misses; }
+
+private:
+
+    const RowSource& source;
+    size_t capacity;
+
+    mutable std::mutex mutex;
+    std::list<size_t> lru; // most recent first
+    std::unordered_map<size_t, std::pair<RowBlock, std::list<size_t>::iterator>> blocks;
+
+    std::atomic<size_t> misses{ 0 };
+};
+
+
+// Per-thread row access through a BlockCache.  Keeps the most recently
+// used few blocks pinned, so a reference returned by row() stays valid
+// while the next PinnedBlocks - 1 rows are read (enough for a comparator).
+class RowReader {
+
+public:
+
+    static constexpr size_t PinnedBlocks = 4;
+
+    explicit RowReader(BlockCache& cache) : cache(cache) {}
+
+    const ItemData& row(size_t index) {
+
+        size_t block = index / RowSource::BlockRows;
+        size_t offset = index % RowSource::BlockRows;
+
+        useCount++;
+
+        Pin* oldest = &pins[0];
+
+        for (auto& pin : pins) {
+
+            if (pin.rows && pin.block == block) {
+                pin.lastUse = useCount;
+                return (*pin.rows)[offset];
+            }
+
+            if (pin.lastUse < oldest->lastUse) {
+                oldest = &pin;
+            }
+        }
+
+        oldest->block = block;
+        oldest->rows = cache.get(block);
+        oldest->lastUse = useCount;
+
+        return (*oldest->rows)[offset];
+    }
+
+    // Drop pinned blocks (e.g. after the cache was cleared)
+    void reset() {
+
+        for (auto& pin : pins) {
+            pin.rows.reset();
+            pin.lastUse = 0;
+        }
+    }
+
+private:
+
+    struct Pin {
+
+        size_t      block{ 0 };
+        RowBlock    rows;
+        uint64_t    lastUse{ 0 };
+    };
+
+    BlockCache& cache;
+    Pin pins[PinnedBlocks];
+    uint64_t useCount{ 0 };
+};
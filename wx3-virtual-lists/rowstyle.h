@@ -0,0 +1,308 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "listmodel.h"
+
+
+// A conditional row style - rows matching the condition get the colours.
+// Conditions: id in [low, high], or a wildcard pattern ('*' and '?') on
+// the name or description column.
+struct RowStyleRule {
+
+    enum class Kind { IdRange, Pattern };
+
+    Kind        kind{ Kind::IdRange };
+    int         column{ 0 };
+    int         low{ 0 };
+    int         high{ 0 };
+    wxString    pattern;
+    wxColour    background;
+
+    // Parse "id 10-20", "name C-*" or "description *power*"
+    static bool parse(const wxString& text, const wxColour& background, RowStyleRule& rule) {
+
+        wxString field = text.BeforeFirst(' ').Lower();
+        wxString value = text.AfterFirst(' ').Trim().Trim(false);
+
+        if (value.IsEmpty()) {
+            return false;
+        }
+
+        rule.background = background;
+
+        if (field == "id") {
+
+            long low = 0, high = 0;
+
+            if (!value.BeforeFirst('-').ToLong(&low)) {
+                return false;
+            }
+
+            if (!value.Contains("-")) {
+                high = low;
+            }
+            else if (!value.AfterFirst('-').ToLong(&high)) {
+                return false;
+            }
+
+            rule.kind = Kind::IdRange;
+            rule.column = 0;
+            rule.low = static_cast<int>(low);
+            rule.high = static_cast<int>(high);
+            return true;
+        }
+
+        if (field == "name" || field == "description") {
+
+            rule.kind = Kind::Pattern;
+            rule.column = (field == "name") ? 1 : 2;
+            rule.pattern = value;
+            return true;
+        }
+
+        return false;
+    }
+};
+
+
+// Evaluates style rules for the list.  Rules are compiled once into column
+// predicates, then run a rule at a time over a batch of rows (the visible
+// page) rather than all rules per row.  The winning rule for each row is
+// cached against the model's data version, so painting a row that has been
+// seen before is a single array lookup however many rules there are.
+class RowStyler {
+
+public:
+
+    void setRules(const std::vector<RowStyleRule>& newRules) {
+
+        rules.clear();
+        attrs.clear();
+
+        for (auto& rule : newRules) {
+
+            rules.push_back(compile(rule));
+
+            auto attr = std::make_unique<wxItemAttr>();
+            attr->SetBackgroundColour(rule.background);
+            attrs.push_back(std::move(attr));
+        }
+
+        invalidate();
+    }
+
+    bool hasRules() const { return !rules.empty(); }
+
+    // Per-row result cache, compiled rules and scratch space
+    size_t memoryBytes() const {
+
+        size_t bytes = MemoryUsage::vectorBytes(cache) + MemoryUsage::vectorBytes(pending) + MemoryUsage::vectorBytes(stillPending);
+
+        bytes += MemoryUsage::vectorBytes(rules) + MemoryUsage::vectorBytes(attrs);
+        bytes += attrs.size() * (sizeof(wxItemAttr) + MemoryUsage::AllocationOverhead);
+
+        return bytes;
+    }
+
+    // Drop all cached results (rules or rows changed)
+    void invalidate() {
+
+        cache.clear();
+        cacheVersion = ~uint64_t{ 0 };
+    }
+
+    // Style for a view row - evaluates [batchFrom, batchTo] on a cache miss
+    wxItemAttr* attrFor(const ListModel& model, long viewIndex, long batchFrom, long batchTo) {
+
+        if (rules.empty()) {
+            return nullptr;
+        }
+
+        sync(model);
+
+        size_t row = model.modelRow(viewIndex);
+
+        if (cache[row] == Unknown) {
+            evaluate(model, viewIndex, batchFrom, batchTo);
+        }
+
+        return attrOf(row);
+    }
+
+    // Style for a model row (e.g. in a grouped list, where list indices
+    // aren't view indices) - on a cache miss, evaluates the model rows
+    // batch() returns (the page being drawn) along with it
+    template <typename Batch>
+    wxItemAttr* attrForRow(const ListModel& model, size_t row, Batch batch) {
+
+        if (rules.empty()) {
+            return nullptr;
+        }
+
+        sync(model);
+
+        if (cache[row] == Unknown) {
+
+            pending.clear();
+            pending.push_back(row);
+
+            for (size_t other : batch()) {
+
+                if (other != row && cache[other] == Unknown) {
+                    pending.push_back(other);
+                }
+            }
+
+            evaluatePending(model);
+        }
+
+        return attrOf(row);
+    }
+
+private:
+
+    // Cache entries: Unknown, NoMatch, or FirstRule + index of winning rule
+    static constexpr uint16_t Unknown = 0;
+    static constexpr uint16_t NoMatch = 1;
+    static constexpr uint16_t FirstRule = 2;
+
+    // Pattern rules are reduced to the cheapest test that is equivalent
+    struct CompiledRule {
+
+        enum class Test { IdRange, Equals, StartsWith, EndsWith, Contains, Wildcard };
+
+        Test        test;
+        int         column;
+        int         low;
+        int         high;
+        wxString    text;
+    };
+
+    std::vector<CompiledRule> rules;
+    std::vector<std::unique_ptr<wxItemAttr>> attrs;
+
+    std::vector<uint16_t> cache;
+    uint64_t cacheVersion{ ~uint64_t{ 0 } };
+
+    // Scratch space reused between batches
+    std::vector<size_t> pending;
+    std::vector<size_t> stillPending;
+
+    void sync(const ListModel& model) {
+
+        if (cacheVersion != model.dataVersion || cache.size() != model.totalRows()) {
+
+            cache.assign(model.totalRows(), Unknown);
+            cacheVersion = model.dataVersion;
+        }
+    }
+
+    wxItemAttr* attrOf(size_t row) const {
+
+        uint16_t result = cache[row];
+        return (result == NoMatch) ? nullptr : attrs[result - FirstRule].get();
+    }
+
+    static CompiledRule compile(const RowStyleRule& rule) {
+
+        if (rule.kind == RowStyleRule::Kind::IdRange) {
+            return { CompiledRule::Test::IdRange, 0, rule.low, rule.high, wxString() };
+        }
+
+        const wxString& p = rule.pattern;
+        wxString inner = p;
+        bool leading = p.StartsWith("*");
+        bool trailing = p.length() > 1 && p.EndsWith("*");
+
+        if (leading) {
+            inner = inner.Mid(1);
+        }
+
+        if (trailing) {
+            inner = inner.Left(inner.length() - 1);
+        }
+
+        if (inner.Contains("*") || inner.Contains("?")) {
+            return { CompiledRule::Test::Wildcard, rule.column, 0, 0, p };
+        }
+
+        auto test = (leading && trailing) ? CompiledRule::Test::Contains
+            : leading ? CompiledRule::Test::EndsWith
+            : trailing ? CompiledRule::Test::StartsWith
+            : CompiledRule::Test::Equals;
+
+        return { test, rule.column, 0, 0, inner };
+    }
+
+    static const wxString& columnText(const ItemData& item, int column) {
+
+        return (column == 1) ? item.name : item.description;
+    }
+
+    static bool test(const CompiledRule& rule, const ItemData& item) {
+
+        switch (rule.test) {
+        case CompiledRule::Test::IdRange: return item.id >= rule.low && item.id <= rule.high;
+        case CompiledRule::Test::Equals: return columnText(item, rule.column) == rule.text;
+        case CompiledRule::Test::StartsWith: return columnText(item, rule.column).StartsWith(rule.text);
+        case CompiledRule::Test::EndsWith: return columnText(item, rule.column).EndsWith(rule.text);
+        case CompiledRule::Test::Contains: return columnText(item, rule.column).Contains(rule.text);
+        case CompiledRule::Test::Wildcard: return columnText(item, rule.column).Matches(rule.text);
+        }
+
+        return false;
+    }
+
+    void evaluate(const ListModel& model, long viewIndex, long batchFrom, long batchTo) {
+
+        // The batch always includes the requested row
+        batchFrom = std::max(0L, std::min(batchFrom, viewIndex));
+        batchTo = std::min(static_cast<long>(model.rowCount()) - 1, std::max(batchTo, viewIndex));
+
+        pending.clear();
+
+        for (long i = batchFrom; i <= batchTo; i++) {
+
+            size_t row = model.modelRow(i);
+
+            if (cache[row] == Unknown) {
+                pending.push_back(row);
+            }
+        }
+
+        evaluatePending(model);
+    }
+
+    // Find the winning rule for each row in pending
+    void evaluatePending(const ListModel& model) {
+
+        // First matching rule wins - each rule only sees rows no earlier
+        // rule has claimed
+        for (size_t r = 0; r < rules.size() && !pending.empty(); r++) {
+
+            const CompiledRule& rule = rules[r];
+            stillPending.clear();
+
+            for (size_t row : pending) {
+
+                if (test(rule, model.row(row))) {
+                    cache[row] = static_cast<uint16_t>(FirstRule + r);
+                }
+                else {
+                    stillPending.push_back(row);
+                }
+            }
+
+            pending.swap(stillPending);
+        }
+
+        for (size_t row : pending) {
+            cache[row] = NoMatch;
+        }
+    }
+};
@@ -0,0 +1,550 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <ctime>
+#include <cerrno>
+#endif
+
+// Shared memory ring for rows from another (local) process - a single
+// producer writes fixed layout records, a single consumer reads them in
+// place.  No wxWidgets here so an ingest process can use it as is.
+
+
+// One row - text is UTF-8, cut (at a character boundary) to fit
+struct SharedRowRecord {
+
+    static constexpr size_t NameBytes = 120;
+    static constexpr size_t DescriptionBytes = 128;
+
+    int32_t     id;
+    uint16_t    nameLength;
+    uint16_t    descriptionLength;
+    char        name[NameBytes];
+    char        description[DescriptionBytes];
+};
+
+static_assert(sizeof(SharedRowRecord) == 256, "record layout is shared between processes");
+
+
+// Start of the mapping.  head/tail count records ever written/read; each
+// is written by one side only and sits on its own cache line.
+struct SharedRingHeader {
+
+    static constexpr uint32_t CurrentVersion = 1;
+
+    char        magic[4];       // "WXLR"
+    uint32_t    version;
+    uint32_t    recordSize;
+    uint32_t    capacity;       // records, a power of two
+
+    alignas(64) std::atomic<uint64_t> head;
+    std::atomic<uint32_t> producerWaiting;  // blocked on a full ring
+    std::atomic<uint32_t> producerClosed;   // no more records coming
+
+    alignas(64) std::atomic<uint64_t> tail;
+    std::atomic<uint32_t> consumerWaiting;  // blocked on an empty ring
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+    "ring counters must be lock free to work across processes");
+
+
+// Named counting semaphore - how each side wakes the other
+class SharedSignal {
+
+public:
+
+    SharedSignal() = default;
+    SharedSignal(const SharedSignal&) = delete;
+    SharedSignal& operator=(const SharedSignal&) = delete;
+
+    ~SharedSignal() {
+
+#ifdef _WIN32
+        if (handle) {
+            CloseHandle(handle);
+        }
+#else
+        if (semaphore != SEM_FAILED) {
+            sem_close(semaphore);
+        }
+
+        if (owner) {
+            sem_unlink(name.c_str());
+        }
+#endif
+    }
+
+    // create: make it (the owner removes the name again when done)
+    bool open(const std::string& signalName, bool create) {
+
+#ifdef _WIN32
+        std::wstring wide(signalName.begin(), signalName.end());
+        handle = create ? CreateSemaphoreW(nullptr, 0, 0x7FFFFFFF, wide.c_str()) : OpenSemaphoreW(SEMAPHORE_ALL_ACCESS, FALSE, wide.c_str());
+        return handle != nullptr;
+#else
+        name = signalName;
+
+        if (create) {
+            sem_unlink(name.c_str()); // left over from a crash
+        }
+
+        semaphore = create ? sem_open(name.c_str(), O_CREAT | O_EXCL, 0600, 0) : sem_open(name.c_str(), 0);
+        owner = create && semaphore != SEM_FAILED;
+        return semaphore != SEM_FAILED;
+#endif
+    }
+
+    void post() {
+
+#ifdef _WIN32
+        ReleaseSemaphore(handle, 1, nullptr);
+#else
+        sem_post(semaphore);
+#endif
+    }
+
+    // false on timeout
+    bool wait(int milliseconds) {
+
+#ifdef _WIN32
+        return WaitForSingleObject(handle, milliseconds) == WAIT_OBJECT_0;
+#elif defined(__APPLE__)
+        // no sem_timedwait - poll
+        for (int waited = 0; waited < milliseconds; waited++) {
+
+            if (sem_trywait(semaphore) == 0) {
+                return true;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return sem_trywait(semaphore) == 0;
+#else
+        timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+
+        until.tv_sec += milliseconds / 1000;
+        until.tv_nsec += (milliseconds % 1000) * 1000000L;
+
+        if (until.tv_nsec >= 1000000000L) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+
+        int result;
+
+        do {
+            result = sem_timedwait(semaphore, &until);
+        } while (result != 0 && errno == EINTR);
+
+        return result == 0;
+#endif
+    }
+
+private:
+
+#ifdef _WIN32
+    HANDLE handle{ nullptr };
+#else
+    std::string name;
+    sem_t* semaphore{ SEM_FAILED };
+    bool owner{ false };
+#endif
+};
+
+
+// The ring's shared memory and signals, for either side.  The consumer
+// (the long running list) creates it; a producer opens it by name.
+class SharedRing {
+
+public:
+
+    static constexpr uint32_t DefaultCapacity = 64 * 1024;   // 16MB of records
+
+    // Longest a blocked side sleeps before looking again (a missed wake-up
+    // only costs this much)
+    static constexpr int WaitMilliseconds = 100;
+
+    SharedRing(const SharedRing&) = delete;
+    SharedRing& operator=(const SharedRing&) = delete;
+
+    ~SharedRing() {
+
+#ifdef _WIN32
+        if (header) {
+            UnmapViewOfFile(header);
+        }
+
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+#else
+        if (header) {
+            munmap(header, length);
+        }
+
+        if (owner) {
+            shm_unlink(shmName.c_str());
+        }
+#endif
+    }
+
+    static std::unique_ptr<SharedRing> create(const std::string& name, uint32_t capacity, std::string& error) {
+
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            error = "Ring capacity must be a power of two";
+            return nullptr;
+        }
+
+        std::unique_ptr<SharedRing> ring(new SharedRing());
+
+        if (!ring->map(name, sizeof(SharedRingHeader) + size_t{ capacity } * sizeof(SharedRowRecord), true, error)
+            || !ring->openSignals(name, true, error)) {
+            return nullptr;
+        }
+
+        SharedRingHeader* header = new (ring->header) SharedRingHeader();
+
+        header->version = SharedRingHeader::CurrentVersion;
+        header->recordSize = sizeof(SharedRowRecord);
+        header->capacity = capacity;
+        ring->recordMask = capacity - 1;
+        header->head = 0;
+        header->tail = 0;
+        header->producerWaiting = 0;
+        header->producerClosed = 0;
+        header->consumerWaiting = 0;
+
+        // magic last - a producer opening early sees an unfinished ring
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header->magic, "WXLR", 4);
+
+        return ring;
+    }
+
+    static std::unique_ptr<SharedRing> open(const std::string& name, std::string& error) {
+
+        std::unique_ptr<SharedRing> ring(new SharedRing());
+
+        if (!ring->map(name, 0, false, error)) {
+            return nullptr;
+        }
+
+        SharedRingHeader* header = ring->header;
+
+        // read once - the other process can write the header at any time
+        uint32_t capacity = (ring->length < sizeof(SharedRingHeader)) ? 0 : header->capacity;
+
+        if (ring->length < sizeof(SharedRingHeader) || std::memcmp(header->magic, "WXLR", 4) != 0
+            || header->version != SharedRingHeader::CurrentVersion || header->recordSize != sizeof(SharedRowRecord)
+            || capacity == 0 || (capacity & (capacity - 1)) != 0
+            || ring->length < sizeof(SharedRingHeader) + size_t{ capacity } * sizeof(SharedRowRecord)) {
+            error = "Not a compatible row ring: " + name;
+            return nullptr;
+        }
+
+        ring->recordMask = capacity - 1;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (!ring->openSignals(name, false, error)) {
+            return nullptr;
+        }
+
+        return ring;
+    }
+
+    // From our own copy, not the header - shared memory the other process
+    // could change after the size was checked
+    uint32_t capacity() const { return recordMask + 1; }
+
+    SharedRingHeader& state() { return *header; }
+
+    SharedRowRecord& record(uint64_t position) {
+
+        return records[position & recordMask];
+    }
+
+    // Posted by the producer when it adds to an empty ring / closes
+    SharedSignal dataReady;
+
+    // Posted by the consumer when it frees space the producer waits for
+    SharedSignal spaceReady;
+
+private:
+
+    SharedRing() = default;
+
+    SharedRingHeader* header{ nullptr };
+    SharedRowRecord* records{ nullptr };
+    size_t length{ 0 };
+    uint32_t recordMask{ 0 };    // capacity - 1, fixed at create/open
+
+#ifdef _WIN32
+    HANDLE mapping{ nullptr };
+#else
+    std::string shmName;
+    bool owner{ false };
+#endif
+
+    static std::string objectName(const std::string& name, const char* suffix) {
+
+#ifdef _WIN32
+        return "Local\\wxlist-" + name + suffix;
+#else
+        return "/wxlist-" + name + suffix;
+#endif
+    }
+
+    bool openSignals(const std::string& name, bool create, std::string& error) {
+
+        if (!dataReady.open(objectName(name, "-data"), create) || !spaceReady.open(objectName(name, "-space"), create)) {
+            error = "Could not open the ring's signals: " + name;
+            return false;
+        }
+
+        return true;
+    }
+
+    // bytes is only used when creating
+    bool map(const std::string& name, size_t bytes, bool create, std::string& error) {
+
+#ifdef _WIN32
+        std::string object = objectName(name, "");
+        std::wstring wide(object.begin(), object.end());
+
+        mapping = create ? CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(uint64_t{ bytes } >> 32), static_cast<DWORD>(bytes), wide.c_str())
+            : OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, wide.c_str());
+
+        if (!mapping) {
+            error = "Could not open shared memory " + object;
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+
+        if (!view) {
+            error = "Could not map shared memory " + object;
+            return false;
+        }
+
+        MEMORY_BASIC_INFORMATION info;
+        VirtualQuery(view, &info, sizeof(info));
+        length = create ? bytes : info.RegionSize;
+#else
+        shmName = objectName(name, "");
+
+        if (create) {
+            shm_unlink(shmName.c_str()); // left over from a crash
+        }
+
+        int fd = shm_open(shmName.c_str(), create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR, 0600);
+
+        if (fd < 0) {
+            error = "Could not open shared memory " + shmName;
+            return false;
+        }
+
+        owner = create;
+
+        struct stat info;
+
+        if ((create && ftruncate(fd, static_cast<off_t>(bytes)) != 0) || fstat(fd, &info) != 0) {
+            ::close(fd);
+            error = "Could not size shared memory " + shmName;
+            return false;
+        }
+
+        length = static_cast<size_t>(info.st_size);
+
+        void* view = (length > 0) ? mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+
+        if (view == MAP_FAILED) {
+            error = "Could not map shared memory " + shmName;
+            return false;
+        }
+#endif
+
+        header = static_cast<SharedRingHeader*>(view);
+        records = reinterpret_cast<SharedRowRecord*>(static_cast<char*>(view) + sizeof(SharedRingHeader));
+        return true;
+    }
+};
+
+
+// Producer side - fills records in place and publishes them in batches
+class SharedRingWriter {
+
+public:
+
+    explicit SharedRingWriter(SharedRing& ring) : ring(ring), head(ring.state().head.load(std::memory_order_relaxed)) {}
+
+    // Next free record to fill, waiting while the ring is full (backpressure).
+    // nullptr if the consumer hasn't freed anything within timeoutMs.
+    SharedRowRecord* claim(int timeoutMs = 5000) {
+
+        SharedRingHeader& state = ring.state();
+
+        auto start = std::chrono::steady_clock::now();
+
+        while (head - state.tail.load(std::memory_order_acquire) >= ring.capacity()) {
+
+            // publish what we have so the consumer can make room
+            publish();
+
+            state.producerWaiting.store(1, std::memory_order_seq_cst);
+
+            // the consumer may have freed space before seeing the flag
+            if (head - state.tail.load(std::memory_order_seq_cst) < ring.capacity()) {
+                break;
+            }
+
+            ring.spaceReady.wait(SharedRing::WaitMilliseconds);
+
+            if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(timeoutMs)) {
+                return nullptr;
+            }
+        }
+
+        return &ring.record(head);
+    }
+
+    // Fill helpers for a claimed record
+    static void setText(char* out, uint16_t& length, size_t capacity, const char* utf8, size_t size) {
+
+        // too long - cut, but not in the middle of a character
+        if (size > capacity) {
+
+            size = capacity;
+
+            while (size > 0 && (static_cast<unsigned char>(utf8[size]) & 0xC0) == 0x80) {
+                size--;
+            }
+        }
+
+        std::memcpy(out, utf8, size);
+        length = static_cast<uint16_t>(size);
+    }
+
+    // The claimed record is complete
+    void commit() {
+
+        head++;
+
+        if (++pending >= PublishBatch) {
+            publish();
+        }
+    }
+
+    // Make committed records visible to the consumer (and wake it)
+    void publish() {
+
+        if (pending == 0) {
+            return;
+        }
+
+        SharedRingHeader& state = ring.state();
+
+        state.head.store(head, std::memory_order_seq_cst);
+        pending = 0;
+
+        if (state.consumerWaiting.exchange(0, std::memory_order_seq_cst)) {
+            ring.dataReady.post();
+        }
+    }
+
+    // No more rows
+    void close() {
+
+        publish();
+
+        ring.state().producerClosed.store(1, std::memory_order_seq_cst);
+        ring.dataReady.post();
+    }
+
+private:
+
+    // Records per head update - fewer cross-core cache line transfers
+    static constexpr size_t PublishBatch = 256;
+
+    SharedRing& ring;
+    uint64_t head;
+    size_t pending{ 0 };
+};
+
+
+// Consumer side - reads published records in place
+class SharedRingReader {
+
+public:
+
+    explicit SharedRingReader(SharedRing& ring) : ring(ring) {}
+
+    // Records published and not yet released
+    uint64_t available() const {
+
+        SharedRingHeader& state = ring.state();
+        return state.head.load(std::memory_order_acquire) - state.tail.load(std::memory_order_relaxed);
+    }
+
+    bool producerClosed() const { return ring.state().producerClosed.load(std::memory_order_acquire) != 0; }
+
+    // i-th available record (valid until released)
+    const SharedRowRecord& peek(uint64_t i) const {
+
+        return ring.record(ring.state().tail.load(std::memory_order_relaxed) + i);
+    }
+
+    // Hand count records back to the producer
+    void release(uint64_t count) {
+
+        SharedRingHeader& state = ring.state();
+
+        state.tail.store(state.tail.load(std::memory_order_relaxed) + count, std::memory_order_seq_cst);
+
+        if (state.producerWaiting.exchange(0, std::memory_order_seq_cst)) {
+            ring.spaceReady.post();
+        }
+    }
+
+    // Block until records are available (or closed) - false on timeout
+    bool waitForData(int milliseconds) {
+
+        SharedRingHeader& state = ring.state();
+
+        state.consumerWaiting.store(1, std::memory_order_seq_cst);
+
+        // the producer may have published before seeing the flag
+        if (available() > 0 || producerClosed()) {
+            state.consumerWaiting.store(0, std::memory_order_relaxed);
+            return true;
+        }
+
+        return ring.dataReady.wait(milliseconds);
+    }
+
+private:
+
+    SharedRing& ring;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <wx/hashmap.h>
+#include <unordered_map>
+
+#include "memoryusage.h"
+
+
+// Memoized text widths keyed by (font, string).  Measuring text goes through
+// the platform font engine and is by far the slowest part of auto-sizing,
+// while the same strings (headers, repeated values) get measured again and
+// again - so look them up first.
+class TextExtentCache {
+
+public:
+
+    // Drop everything once this many strings have been cached for a font
+    static constexpr size_t MaxEntriesPerFont = 64 * 1024;
+
+    // Width in pixels of text drawn with the DC's current font
+    int width(wxDC& dc, const wxString& text) {
+
+        auto& widths = widthsFor(dc.GetFont());
+
+        auto found = widths.find(text);
+
+        if (found != widths.end()) {
+            return found->second;
+        }
+
+        if (widths.size() >= MaxEntriesPerFont) {
+            widths.clear();
+        }
+
+        int w = dc.GetTextExtent(text).GetWidth();
+        widths.emplace(text, w);
+
+        return w;
+    }
+
+    void clear() {
+
+        fonts.clear();
+        lastFont.clear();
+        lastWidths = nullptr;
+    }
+
+    size_t size() const {
+
+        size_t total = 0;
+
+        for (auto& font : fonts) {
+            total += font.second.size();
+        }
+
+        return total;
+    }
+
+    // Hash nodes, bucket arrays and string buffers
+    size_t memoryBytes() const {
+
+        const size_t node = sizeof(void*) + sizeof(size_t) + sizeof(wxString) + sizeof(int) + MemoryUsage::AllocationOverhead;
+
+        size_t bytes = fonts.bucket_count() * sizeof(void*);
+
+        for (auto& font : fonts) {
+
+            bytes += node + sizeof(WidthMap) + MemoryUsage::stringHeapBytes(font.first);
+            bytes += font.second.bucket_count() * sizeof(void*);
+
+            for (auto& entry : font.second) {
+                bytes += node + MemoryUsage::stringHeapBytes(entry.first);
+            }
+        }
+
+        return bytes;
+    }
+
+private:
+
+    using WidthMap = std::unordered_map<wxString, int, wxStringHash, wxStringEqual>;
+
+    std::unordered_map<wxString, WidthMap, wxStringHash, wxStringEqual> fonts;
+
+    // Usually every call is for the same font - skip the outer lookup
+    wxString lastFont;
+    WidthMap* lastWidths{ nullptr };
+
+    WidthMap& widthsFor(const wxFont& font) {
+
+        wxString key = font.GetNativeFontInfoDesc();
+
+        if (lastWidths == nullptr || key != lastFont) {
+            lastFont = key;
+            lastWidths = &fonts[key];
+        }
+
+        return *lastWidths;
+    }
+};
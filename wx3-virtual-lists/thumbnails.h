@@ -0,0 +1,357 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <wx/imaglist.h>
+#include <wx/hashmap.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <cstdint>
+
+#include "memoryusage.h"
+
+
+// Box filter downscale of an image to fit size x size, centred on a
+// transparent square.  Colours are averaged premultiplied by alpha so
+// transparent pixels don't bleed into the edges.  The inner loops run over
+// plain byte/uint32 rows so the compiler can vectorize them.
+inline wxImage downscaleThumbnail(const wxImage& source, int size) {
+
+    int width = source.GetWidth();
+    int height = source.GetHeight();
+    int longest = std::max(width, height);
+
+    int outWidth = std::max(1, width * size / longest);
+    int outHeight = std::max(1, height * size / longest);
+
+    if (longest <= size) {
+        outWidth = width;
+        outHeight = height;
+    }
+
+    const unsigned char* rgb = source.GetData();
+    const unsigned char* alpha = source.HasAlpha() ? source.GetAlpha() : nullptr;
+
+    // premultiplied RGBA of one source row, and the sum over a band of rows
+    std::vector<uint32_t> row(static_cast<size_t>(width) * 4);
+    std::vector<uint32_t> band(static_cast<size_t>(width) * 4);
+
+    wxImage thumbnail(size, size);
+    thumbnail.InitAlpha();
+
+    unsigned char* outRgb = thumbnail.GetData();
+    unsigned char* outAlpha = thumbnail.GetAlpha();
+
+    std::fill(outRgb, outRgb + size * size * 3, 0);
+    std::fill(outAlpha, outAlpha + size * size, 0);
+
+    int left = (size - outWidth) / 2;
+    int top = (size - outHeight) / 2;
+
+    for (int oy = 0; oy < outHeight; oy++) {
+
+        int y0 = oy * height / outHeight;
+        int y1 = std::max(y0 + 1, (oy + 1) * height / outHeight);
+
+        std::fill(band.begin(), band.end(), 0);
+
+        for (int y = y0; y < y1; y++) {
+
+            const unsigned char* in = rgb + static_cast<size_t>(y) * width * 3;
+            const unsigned char* inAlpha = alpha ? alpha + static_cast<size_t>(y) * width : nullptr;
+
+            for (int x = 0; x < width; x++) {
+
+                uint32_t a = inAlpha ? inAlpha[x] : 255;
+
+                row[x * 4 + 0] = in[x * 3 + 0] * a;
+                row[x * 4 + 1] = in[x * 3 + 1] * a;
+                row[x * 4 + 2] = in[x * 3 + 2] * a;
+                row[x * 4 + 3] = a;
+            }
+
+            for (size_t i = 0; i < band.size(); i++) {
+                band[i] += row[i];
+            }
+        }
+
+        for (int ox = 0; ox < outWidth; ox++) {
+
+            int x0 = ox * width / outWidth;
+            int x1 = std::max(x0 + 1, (ox + 1) * width / outWidth);
+
+            uint64_t sum[4] = { 0, 0, 0, 0 };
+
+            for (int x = x0; x < x1; x++) {
+                for (int c = 0; c < 4; c++) {
+                    sum[c] += band[x * 4 + c];
+                }
+            }
+
+            size_t at = static_cast<size_t>(top + oy) * size + left + ox;
+            uint64_t pixels = static_cast<uint64_t>(x1 - x0) * (y1 - y0);
+
+            outAlpha[at] = static_cast<unsigned char>(sum[3] / pixels);
+
+            if (sum[3] > 0) {
+                for (int c = 0; c < 3; c++) {
+                    outRgb[at * 3 + c] = static_cast<unsigned char>(sum[c] / sum[3]);
+                }
+            }
+        }
+    }
+
+    return thumbnail;
+}
+
+
+// Decodes and downscales images on a small thread pool.  Newest requests
+// are served first and only the latest MaxQueued are kept, so after fast
+// scrolling the pool works on what is on screen now, not on what went
+// past.  Results are delivered on the UI thread via notify->CallAfter.
+class ThumbnailLoader {
+
+public:
+
+    using ReadyCallback = std::function<void(const wxString& path, const wxImage& thumbnail)>;
+
+    static constexpr size_t MaxQueued = 256;
+
+    ThumbnailLoader(int size, wxEvtHandler* notify, ReadyCallback onReady) : size(size), notify(notify), onReady(onReady) {
+
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([this]() { run(); });
+        }
+    }
+
+    ~ThumbnailLoader() {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wake.notify_all();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Load path unless it is already queued or loading
+    void request(const wxString& path) {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (!pending.insert(path).second) {
+                return;
+            }
+
+            queue.push_back(path);
+
+            if (queue.size() > MaxQueued) {
+                pending.erase(queue.front());
+                queue.pop_front();
+            }
+        }
+
+        wake.notify_one();
+    }
+
+    // UI thread - a delivered result's path may be requested again
+    void finished(const wxString& path) {
+
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.erase(path);
+    }
+
+private:
+
+    int size;
+    wxEvtHandler* notify;
+    ReadyCallback onReady;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    std::deque<wxString> queue;
+    std::unordered_set<wxString, wxStringHash, wxStringEqual> pending;   // queued or loading
+    bool stopping{ false };
+
+    void run() {
+
+        // failures show as the placeholder - no message boxes from here
+        wxLogNull noLog;
+
+        while (true) {
+
+            wxString path;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+
+                if (stopping) {
+                    return;
+                }
+
+                path = queue.back();
+                queue.pop_back();
+            }
+
+            // wxImage reference counts aren't thread safe - hand over one
+            // that only this thread has touched, through a shared_ptr
+            auto thumbnail = std::make_shared<wxImage>();
+            wxImage image;
+
+            if (image.LoadFile(path) && image.IsOk()) {
+                *thumbnail = downscaleThumbnail(image, size);
+            }
+
+            // owner may be gone by the time this runs - onReady checks
+            notify->CallAfter([onReady = onReady, path, thumbnail]() {
+                onReady(path, *thumbnail);
+                });
+        }
+    }
+};
+
+
+// Thumbnails for list rows, decoded in the background and kept in a
+// fixed size image list used as an LRU cache.  Slot 0 is a placeholder
+// shown until a row's thumbnail is ready; imageFor never waits.
+class ThumbnailCache {
+
+public:
+
+    static constexpr int Size = 32;
+    static constexpr size_t Capacity = 512;
+
+    // onUpdated: new thumbnails are ready (refresh what's visible)
+    static std::shared_ptr<ThumbnailCache> create(wxEvtHandler* notify, std::function<void()> onUpdated) {
+
+        std::shared_ptr<ThumbnailCache> cache(new ThumbnailCache(onUpdated));
+        std::weak_ptr<ThumbnailCache> weak = cache;
+
+        cache->loader = std::make_unique<ThumbnailLoader>(Size, notify, [weak](const wxString& path, const wxImage& thumbnail) {
+            if (auto owner = weak.lock()) {
+                owner->store(path, thumbnail);
+            }
+            });
+
+        return cache;
+    }
+
+    wxImageList* imageList() { return &images; }
+
+    // Image list index for an image file - the placeholder until loaded
+    int imageFor(const wxString& path) {
+
+        auto found = slots.find(path);
+
+        if (found == slots.end()) {
+            loader->request(path);
+            return Placeholder;
+        }
+
+        // most recently used to the front
+        recent.splice(recent.begin(), recent, found->second.used);
+        return found->second.slot;
+    }
+
+    size_t memoryBytes() const {
+
+        return images.GetImageCount() * static_cast<size_t>(Size * Size * 4) + slots.size() * (sizeof(wxString) + sizeof(Entry) + 4 * sizeof(void*));
+    }
+
+private:
+
+    static constexpr int Placeholder = 0;
+
+    struct Entry {
+
+        int slot;
+        std::list<wxString>::iterator used;
+    };
+
+    wxImageList images{ Size, Size, false, static_cast<int>(Capacity) + 1 };
+    std::unique_ptr<ThumbnailLoader> loader;
+    std::function<void()> onUpdated;
+
+    std::unordered_map<wxString, Entry, wxStringHash, wxStringEqual> slots;
+    std::list<wxString> recent;     // paths, most recently used first
+
+    explicit ThumbnailCache(std::function<void()> onUpdated) : onUpdated(onUpdated) {
+
+        images.Add(placeholder());
+    }
+
+    // UI thread
+    void store(const wxString& path, const wxImage& thumbnail) {
+
+        loader->finished(path);
+
+        if (slots.count(path)) {
+            return;
+        }
+
+        // unreadable files keep the placeholder (and aren't retried while cached)
+        wxBitmap bitmap = thumbnail.IsOk() ? wxBitmap(thumbnail) : placeholder();
+
+        int slot;
+
+        if (static_cast<size_t>(images.GetImageCount()) <= Capacity) {
+            slot = images.Add(bitmap);
+        }
+        else {
+
+            // evict the least recently used
+            auto oldest = slots.find(recent.back());
+            slot = oldest->second.slot;
+
+            slots.erase(oldest);
+            recent.pop_back();
+
+            images.Replace(slot, bitmap);
+        }
+
+        recent.push_front(path);
+        slots[path] = { slot, recent.begin() };
+
+        onUpdated();
+    }
+
+    static wxBitmap placeholder() {
+
+        wxImage image(Size, Size);
+        image.InitAlpha();
+
+        unsigned char* alpha = image.GetAlpha();
+
+        // light grey rounded-ish square
+        for (int y = 0; y < Size; y++) {
+            for (int x = 0; x < Size; x++) {
+
+                bool corner = (x < 2 || x >= Size - 2) && (y < 2 || y >= Size - 2);
+                bool edge = x == 0 || y == 0 || x == Size - 1 || y == Size - 1;
+
+                image.SetRGB(x, y, edge ? 180 : 225, edge ? 180 : 225, edge ? 180 : 225);
+                alpha[y * Size + x] = corner ? 0 : 255;
+            }
+        }
+
+        return wxBitmap(image);
+    }
+};
@@ -0,0 +1,914 @@
+#pragma once
+
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+#include <wx/settings.h>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "listmodel.h"
+#include "textextent.h"
+#include "rowstyle.h"
+#include "modelmerge.h"
+#include "computedcolumn.h"
+#include "grouptree.h"
+#include "thumbnails.h"
+#include "columnschema.h"
+
+
+// Virtual list subclass - virtual lists special case of report view
+class VirtualList : public wxListCtrl {
+
+private:
+
+    // Store reference to model
+    ListModel* hostModel{ nullptr };
+
+    // Measured text widths reused across auto-fits
+    TextExtentCache extents;
+
+    // Conditional row colours (cache is filled while painting, hence mutable)
+    mutable RowStyler styler;
+
+    // Per-row change flags when showing a merged model (by model row)
+    std::vector<RowChange> rowChanges;
+    wxItemAttr addedAttr, removedAttr, changedAttr;
+
+    // What each list column shows
+    ColumnSchema schema;
+
+    // Derived columns, shown after the model's own
+    std::vector<std::shared_ptr<ComputedColumn>> computed;
+
+    // Columns [visibleFirst, visibleLast] intersect the horizontal viewport,
+    // worked out once per paint.  While the list paints only those are
+    // formatted (see OnGetItemText).
+    int visibleFirst{ 0 };
+    int visibleLast{ -1 };
+    bool painting{ false };
+    bool fitPending{ false };
+
+    // Grouped (tree) mode - rows under a collapsible header per key value
+    std::unique_ptr<GroupTree> tree;
+    std::shared_ptr<ComputedColumn> groupKey;
+    wxItemAttr groupAttr;
+
+    // List rows about to be drawn (from the last cache hint) and, in
+    // grouped mode, the model rows among them
+    long hintFrom{ 0 };
+    long hintTo{ -1 };
+    mutable std::vector<size_t> pageRows;
+
+    // Row thumbnails shown in the first column (nullptr = none)
+    std::shared_ptr<ThumbnailCache> thumbnails;
+    std::function<wxString(const ItemData&)> thumbnailPath;
+
+public:
+
+    // Number of OnGetItemText calls so far (for the scroll benchmark)
+    mutable size_t textRequests{ 0 };
+
+    VirtualList(wxWindow* parent, const wxWindowID id, const wxPoint& pos, const wxSize& size, ListModel *model) : wxListCtrl(parent, id, pos, size, wxLC_REPORT | wxLC_VIRTUAL | wxLC_EDIT_LABELS) {
+
+        // Link to model
+        this->hostModel = model;
+
+        // Setup list columns
+        appendColumn(ColumnSchema::Kind::Model, 0, "ID", 80);
+        appendColumn(ColumnSchema::Kind::Model, 1, "Name", 120);
+        appendColumn(ColumnSchema::Kind::Model, 2, "Description", 600);
+
+        // The list says which rows it's about to draw - let the model
+        // decode them (and what comes next) before they're asked for
+        Bind(wxEVT_LIST_CACHE_HINT, [this](wxListEvent& event) {
+
+            hintFrom = event.GetCacheFrom();
+            hintTo = event.GetCacheTo();
+
+            // list indices aren't view indices when grouped
+            if (!tree) {
+                hostModel->cacheHint(hintFrom, hintTo);
+            }
+            });
+
+        // Groups open/close on double click/Enter, or Right/Left
+        Bind(wxEVT_LIST_ITEM_ACTIVATED, [this](wxListEvent& event) {
+
+            if (!tree || !toggleGroup(event.GetIndex())) {
+                event.Skip();
+            }
+            });
+
+        Bind(wxEVT_LIST_KEY_DOWN, [this](wxListEvent& event) {
+
+            int key = event.GetKeyCode();
+            long index = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_FOCUSED);
+
+            if (!tree || index == -1 || (key != WXK_LEFT && key != WXK_RIGHT) || !toggleGroup(index, key == WXK_RIGHT)) {
+                event.Skip();
+            }
+            });
+
+#ifndef __WXMSW__
+        // the generic list paints in a child window (MSW: see MSWWindowProc)
+        GetMainWindow()->Bind(wxEVT_PAINT, [this](wxPaintEvent& event) { beginPaint(); event.Skip(); });
+#endif
+
+        groupAttr.SetFont(GetFont().Bold());
+        groupAttr.SetBackgroundColour(wxSystemSettings::GetColour(wxSYS_COLOUR_BTNFACE));
+    }
+
+    // Override method to query data for list element
+    virtual wxString OnGetItemText(long index, long column) const override {
+
+        textRequests++;
+
+        // scrolled out of view sideways - not drawn, so not formatted (other
+        // callers, e.g. type-ahead and accessibility, get the text)
+        if (painting && (column < visibleFirst || column > visibleLast)) {
+            return wxString();
+        }
+
+        if (tree) {
+            return groupedText(index, column);
+        }
+
+        // computed columns are evaluated for the whole visible page at once
+        if (schema.kind(column) == ColumnSchema::Kind::Computed) {
+
+            long top = GetTopItem();
+            return computed[schema.source(column)]->text(*hostModel, index, top, top + GetCountPerPage());
+        }
+
+        // index is a view index - model maps it to the (sorted/filtered) row
+        return ListModel::cellText(hostModel->itemAt(index), schema.source(column));
+    }
+
+    // Thumbnail (or its placeholder) before the first column's text
+    virtual int OnGetItemColumnImage(long index, long column) const override {
+
+        if (!thumbnails || column != 0) {
+            return -1;
+        }
+
+        size_t row;
+
+        if (tree) {
+
+            GroupTree::Node node = tree->at(index);
+
+            if (node.isGroup) {
+                return -1;
+            }
+
+            row = node.row;
+        }
+        else {
+            row = hostModel->modelRow(index);
+        }
+
+        return thumbnails->imageFor(thumbnailPath(hostModel->row(row)));
+    }
+
+    virtual int OnGetItemImage(long index) const override {
+
+        return OnGetItemColumnImage(index, 0);
+    }
+
+    // Row colours from the style rules - the whole visible page is evaluated
+    // the first time any row of it is asked for
+    virtual wxItemAttr* OnGetItemAttr(long index) const override {
+
+        if (!rowChanges.empty()) {
+            return changeAttr(rowChanges[hostModel->modelRow(index)]);
+        }
+
+        if (tree) {
+
+            GroupTree::Node node = tree->at(index);
+
+            if (node.isGroup) {
+                return const_cast<wxItemAttr*>(&groupAttr);
+            }
+
+            return styler.attrForRow(*hostModel, node.row, [this, index]() -> const std::vector<size_t>& { return groupedPageRows(index); });
+        }
+
+        long top = GetTopItem();
+        return styler.attrFor(*hostModel, index, top, top + GetCountPerPage());
+    }
+
+    // Group rows by the value of key (nullptr goes back to a flat list)
+    void setGrouping(std::shared_ptr<ComputedColumn> key) {
+
+        groupKey = std::move(key);
+        tree.reset();
+
+        if (groupKey) {
+            tree = std::make_unique<GroupTree>();
+        }
+
+        RefreshAfterUpdate();
+    }
+
+    bool isGrouped() const { return tree != nullptr; }
+
+    // Expand/collapse every group
+    void setAllExpanded(bool expand) {
+
+        if (tree) {
+            tree->setAllExpanded(expand);
+            RefreshAfterUpdate();
+        }
+    }
+
+    // Open or close the group whose header (or one of whose rows) is at
+    // index - the flattened row mapping is patched, not rebuilt
+    bool toggleGroup(long index) {
+
+        GroupTree::Node node = tree->at(index);
+        return toggleGroup(index, !tree->isExpanded(node.group));
+    }
+
+    bool toggleGroup(long index, bool expand) {
+
+        GroupTree::Node node = tree->at(index);
+
+        if (tree->isExpanded(node.group) == expand) {
+            return false;
+        }
+
+        // collapsing from a row - keep the focus on its header
+        long header = static_cast<long>(tree->headerIndex(node.group));
+
+        // selection is by index and every row below the group moves - drop
+        // it, the header alone is selected afterwards
+        SetItemState(-1, 0, wxLIST_STATE_SELECTED);
+
+        tree->setExpanded(node.group, expand);
+
+        SetItemCount(tree->visibleCount());
+        SetItemState(header, wxLIST_STATE_FOCUSED | wxLIST_STATE_SELECTED, wxLIST_STATE_FOCUSED | wxLIST_STATE_SELECTED);
+
+        // collapsing from deep inside a big group leaves the header far above
+        EnsureVisible(header);
+
+        long top = GetTopItem();
+        RefreshItems(std::max(header, top), std::min(top + GetCountPerPage() + 1, static_cast<long>(tree->visibleCount()) - 1));
+        return true;
+    }
+
+    wxString groupedText(long index, long column) const {
+
+        GroupTree::Node node = tree->at(index);
+
+        if (node.isGroup) {
+
+            switch (column) {
+            case 0: return (tree->isExpanded(node.group) ? "- " : "+ ") + tree->groupLabel(node.group);
+            case 1: return wxString::Format("%zu rows", tree->groupSize(node.group));
+            default: return wxString("");
+            }
+        }
+
+        if (schema.kind(column) == ColumnSchema::Kind::Model) {
+
+            wxString text = ListModel::cellText(hostModel->row(node.row), schema.source(column));
+            return (column == 0) ? "    " + text : text;
+        }
+
+        // computed columns are evaluated for the rows being drawn in one
+        // batch - the row list is only built on a miss (once per page)
+        auto derived = computed[schema.source(column)];
+
+        return derived->text(*hostModel, node.row, [this, index]() -> const std::vector<size_t>& { return groupedPageRows(index); });
+    }
+
+    // Model rows of the list rows being drawn (the cache hint range, or the
+    // page from the top item for a row outside it)
+    const std::vector<size_t>& groupedPageRows(long index) const {
+
+        long from = hintFrom;
+        long to = hintTo;
+
+        if (index < from || index > to) {
+            from = GetTopItem();
+            to = from + GetCountPerPage();
+        }
+
+        to = std::min(to, static_cast<long>(tree->visibleCount()) - 1);
+
+        pageRows.clear();
+
+        for (long i = from; i <= to; i++) {
+
+            GroupTree::Node visible = tree->at(i);
+
+            if (!visible.isGroup) {
+                pageRows.push_back(visible.row);
+            }
+        }
+
+        return pageRows;
+    }
+
+    // Show a thumbnail of the image file pathFor names on every row (an
+    // empty function hides them).  Images are decoded in the background;
+    // rows show a placeholder until theirs is ready.
+    void showThumbnails(std::function<wxString(const ItemData&)> pathFor) {
+
+        SetImageList(nullptr, wxIMAGE_LIST_SMALL);
+        thumbnails.reset();
+        thumbnailPath = pathFor;
+
+        if (pathFor) {
+
+            thumbnails = ThumbnailCache::create(this, [this]() {
+                long top = GetTopItem();
+                RefreshItems(top, std::min<long>(top + GetCountPerPage(), GetItemCount() - 1));
+                });
+
+            SetImageList(thumbnails->imageList(), wxIMAGE_LIST_SMALL);
+        }
+
+        Refresh();
+    }
+
+    // Add what the list holds on top of the model
+    void memoryUsage(MemoryUsage& usage) const {
+
+        usage.add("Index", "row style results", styler.memoryBytes());
+        usage.add("Index", "row change flags (compare)", MemoryUsage::vectorBytes(rowChanges));
+        usage.add("Cache", "text extents", extents.memoryBytes());
+        usage.add("Index", wxString::Format("column schema (%zu columns)", schema.size()), schema.memoryBytes());
+
+        for (auto& column : computed) {
+            usage.add("Cache", "computed: " + column->expression(), column->memoryBytes());
+        }
+
+        if (thumbnails) {
+            usage.add("Cache", "thumbnails", thumbnails->memoryBytes());
+        }
+
+        if (tree) {
+            usage.add("Index", "group tree: " + groupKey->expression(), tree->memoryBytes());
+            usage.add("Cache", "group key: " + groupKey->expression(), groupKey->memoryBytes());
+        }
+    }
+
+    // Selected rows for a background job: rows maps positions to model
+    // rows, ranges are the selected positions as [first, last] runs.  A
+    // flat list hands over the view permutation and the selection runs
+    // (no per-row work here); a grouped one lists the selected rows, with
+    // a collapsed header standing for its whole group.
+    void selectionSnapshot(std::vector<size_t>& rows, std::vector<std::pair<size_t, size_t>>& ranges) const {
+
+        rows.clear();
+        ranges.clear();
+
+        if (GetSelectedItemCount() == 0) {
+            return;
+        }
+
+        if (tree) {
+
+            for (long i = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED); i != -1; i = GetNextItem(i, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)) {
+
+                GroupTree::Node node = tree->at(i);
+
+                if (!node.isGroup) {
+                    rows.push_back(node.row);
+                }
+                else if (!tree->isExpanded(node.group)) {
+                    tree->appendRows(node.group, rows);
+                }
+            }
+
+            if (!rows.empty()) {
+                ranges.emplace_back(0, rows.size() - 1);
+            }
+
+            return;
+        }
+
+        rows = hostModel->viewRows();
+
+        if (GetSelectedItemCount() == GetItemCount()) {
+            ranges.emplace_back(0, rows.size() - 1);
+            return;
+        }
+
+        for (long i = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED); i != -1; i = GetNextItem(i, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)) {
+
+            if (!ranges.empty() && ranges.back().second + 1 == static_cast<size_t>(i)) {
+                ranges.back().second = i;
+            }
+            else {
+                ranges.emplace_back(i, i);
+            }
+        }
+    }
+
+    // Colour rows by how they changed (see mergeById)
+    void setRowChanges(std::vector<RowChange> changes) {
+
+        rowChanges = std::move(changes);
+
+        addedAttr.SetBackgroundColour(wxColour(198, 239, 206));
+        removedAttr.SetBackgroundColour(wxColour(255, 199, 206));
+        changedAttr.SetBackgroundColour(wxColour(255, 235, 156));
+
+        Refresh();
+    }
+
+    wxItemAttr* changeAttr(RowChange change) const {
+
+        switch (change) {
+        case RowChange::Added: return const_cast<wxItemAttr*>(&addedAttr);
+        case RowChange::Removed: return const_cast<wxItemAttr*>(&removedAttr);
+        case RowChange::Changed: return const_cast<wxItemAttr*>(&changedAttr);
+        default: return nullptr;
+        }
+    }
+
+    // Add a column derived from the model's (see ComputedColumn)
+    void addComputedColumn(std::shared_ptr<ComputedColumn> column) {
+
+        computed.push_back(std::move(column));
+        appendColumn(ColumnSchema::Kind::Computed, static_cast<uint32_t>(computed.size() - 1), computed.back()->expression(), DefaultWidth);
+        autoFitColumn(GetColumnCount() - 1);
+    }
+
+    // Add many columns at once - each is sized to its content when it
+    // first scrolls into view
+    void addComputedColumns(const std::vector<std::shared_ptr<ComputedColumn>>& columns) {
+
+        Freeze();
+
+        for (auto& column : columns) {
+            computed.push_back(column);
+            appendColumn(ColumnSchema::Kind::Computed, static_cast<uint32_t>(computed.size() - 1), column->expression(), DefaultWidth, false);
+        }
+
+        Thaw();
+        Refresh();
+    }
+
+    // Computed column for a list column (nullptr for the model's own)
+    std::shared_ptr<ComputedColumn> computedColumn(int column) const {
+
+        if (column < 0 || column >= static_cast<int>(schema.size()) || schema.kind(column) != ColumnSchema::Kind::Computed) {
+            return nullptr;
+        }
+
+        return computed[schema.source(column)];
+    }
+
+    // Model column a list column shows (-1 for computed columns)
+    int modelColumn(int column) const {
+
+        return (column >= 0 && column < static_cast<int>(schema.size()) && schema.kind(column) == ColumnSchema::Kind::Model)
+            ? static_cast<int>(schema.source(column)) : -1;
+    }
+
+    void setStyleRules(const std::vector<RowStyleRule>& rules) {
+
+        styler.setRules(rules);
+        Refresh();
+    }
+
+    // Selection, focus and scroll position by row id (group label for a
+    // grouped list's header rows), so they can be put back after the rows
+    // underneath have moved
+    struct ViewState {
+
+        // What a list row shows
+        struct Key {
+
+            int         id{ 0 };
+            wxString    group;
+            bool        isGroup{ false };
+
+            bool operator==(const Key& other) const {
+                return isGroup == other.isGroup && (isGroup ? group == other.group : id == other.id);
+            }
+        };
+
+        std::vector<Key> selected;
+        std::vector<Key> visible;       // top row first
+        Key focused;
+        bool hasFocus{ false };
+    };
+
+    ViewState saveViewState() const {
+
+        ViewState state;
+
+        for (long i = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED); i != -1; i = GetNextItem(i, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)) {
+            state.selected.push_back(keyAt(i));
+        }
+
+        long focused = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_FOCUSED);
+
+        if (focused != -1) {
+            state.focused = keyAt(focused);
+            state.hasFocus = true;
+        }
+
+        long top = GetTopItem();
+        long end = std::min<long>(top + GetCountPerPage() + 1, listRowCount());
+
+        for (long i = top; i < end; i++) {
+            state.visible.push_back(keyAt(i));
+        }
+
+        return state;
+    }
+
+    // After the model was patched (ListModel::applyUpdate): regroup if
+    // grouped, reselect rows by id, scroll so the same row is on top, and
+    // repaint only the visible rows that differ from before (moved, edited
+    // or new)
+    void restoreViewState(const ViewState& state, const std::vector<size_t>& changedRows) {
+
+        // no Freeze/Thaw - thawing repaints the whole window, and only the
+        // rows that changed are meant to be repainted
+
+        // clear old selection (indices refer to the old view)
+        for (long i = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED); i != -1; i = GetNextItem(i, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)) {
+            SetItemState(i, 0, wxLIST_STATE_SELECTED);
+        }
+
+        if (tree && tree->version() != hostModel->version) {
+            tree->build(*hostModel, *groupKey);
+        }
+
+        long count = listRowCount();
+
+        if (GetItemCount() != count) {
+            SetItemCount(count);
+        }
+
+        // find where the remembered rows are now (one pass over the list)
+        std::unordered_map<int, long> ids;
+        std::unordered_map<wxString, long, wxStringHash, wxStringEqual> groups;
+
+        auto remember = [&](const ViewState::Key& key) {
+            if (key.isGroup) {
+                groups.emplace(key.group, -1);
+            }
+            else {
+                ids.emplace(key.id, -1);
+            }
+            };
+
+        for (auto& key : state.selected) {
+            remember(key);
+        }
+
+        for (auto& key : state.visible) {
+            remember(key);
+        }
+
+        if (state.hasFocus) {
+            remember(state.focused);
+        }
+
+        if (tree) {
+
+            // headers by label - O(log groups) each
+            for (size_t g = 0; g < tree->groupCount() && !groups.empty(); g++) {
+
+                auto found = groups.find(tree->groupLabel(g));
+
+                if (found != groups.end()) {
+                    found->second = static_cast<long>(tree->headerIndex(g));
+                }
+            }
+        }
+
+        if (!ids.empty()) {
+
+            for (long i = 0; i < count; i++) {
+
+                // headers were found above (rows of collapsed groups aren't listed)
+                long row = modelRowAt(i);
+
+                if (row < 0) {
+                    continue;
+                }
+
+                auto found = ids.find(hostModel->row(static_cast<size_t>(row)).id);
+
+                if (found != ids.end() && found->second == -1) {
+                    found->second = i;
+                }
+            }
+        }
+
+        auto indexOf = [&](const ViewState::Key& key) {
+            return key.isGroup ? groups[key.group] : ids[key.id];
+            };
+
+        for (auto& key : state.selected) {
+
+            long now = indexOf(key);
+
+            if (now != -1) {
+                SetItemState(now, wxLIST_STATE_SELECTED, wxLIST_STATE_SELECTED);
+            }
+        }
+
+        if (state.hasFocus && indexOf(state.focused) != -1) {
+            SetItemState(indexOf(state.focused), wxLIST_STATE_FOCUSED, wxLIST_STATE_FOCUSED);
+        }
+
+        // keep the first surviving row of the old page at the top
+        for (auto& key : state.visible) {
+
+            long now = indexOf(key);
+
+            if (now == -1) {
+                continue;
+            }
+
+            long top = GetTopItem();
+            wxRect rect;
+
+            if (now != top && GetItemRect(top, rect)) {
+                ScrollList(0, static_cast<int>((now - top) * rect.GetHeight()));
+            }
+
+            break;
+        }
+
+        // repaint visible rows that show something different now
+        std::unordered_set<size_t> changed(changedRows.begin(), changedRows.end());
+
+        long top = GetTopItem();
+        long end = std::min<long>(top + GetCountPerPage() + 1, count);
+        long runStart = -1;
+
+        for (long i = top; i <= end; i++) {
+
+            bool differs = false;
+
+            if (i < end) {
+
+                size_t slot = static_cast<size_t>(i - top);
+                long row = modelRowAt(i);
+
+                differs = (row >= 0 && changed.count(static_cast<size_t>(row)) != 0)
+                    || slot >= state.visible.size()
+                    || !(state.visible[slot] == keyAt(i));
+            }
+
+            if (differs && runStart == -1) {
+                runStart = i;
+            }
+            else if (!differs && runStart != -1) {
+                RefreshItems(runStart, i - 1);
+                runStart = -1;
+            }
+        }
+
+        // rows past the end of a shorter list
+        if (end < top + static_cast<long>(state.visible.size())) {
+            Refresh();
+        }
+    }
+
+    // Refresh list count and update list itself once changes made
+    void RefreshAfterUpdate() {
+
+        // regroup after sort/filter/data changes
+        if (tree && tree->version() != hostModel->version) {
+            tree->build(*hostModel, *groupKey);
+        }
+
+        SetItemCount(tree ? tree->visibleCount() : hostModel->rowCount());
+        Refresh();
+    }
+
+    // Size a column to its content.  wxLIST_AUTOSIZE would measure every row
+    // of a virtual list, so estimate from a stratified sample of the view
+    // plus the longest cells recorded in the column statistics.
+    void autoFitColumn(int column) {
+
+        const int SampleCount = 256;
+        const int Padding = 16;
+        const int MaxWidth = 1000;
+
+        wxClientDC dc(this);
+        dc.SetFont(GetFont());
+
+        wxListItem header;
+        header.SetMask(wxLIST_MASK_TEXT);
+        GetColumn(column, header);
+
+        int width = extents.width(dc, header.GetText());
+
+        // One row from each equal-sized stratum (offset varies per stratum so
+        // regular patterns in the data don't line up with the sample)
+        std::vector<size_t> sample;
+        size_t rows = hostModel->rowCount();
+        size_t strata = std::min<size_t>(rows, SampleCount);
+
+        for (size_t s = 0; s < strata; s++) {
+
+            size_t begin = s * rows / strata;
+            size_t end = (s + 1) * rows / strata;
+            size_t offset = (s * 2654435761u) % (end - begin);
+
+            sample.push_back(hostModel->modelRow(static_cast<long>(begin + offset)));
+        }
+
+        auto derived = computedColumn(column);
+
+        if (derived) {
+            derived->prepare(*hostModel, sample);
+        }
+        else {
+            auto& longest = hostModel->columnStats(modelColumn(column)).longestRows;
+            sample.insert(sample.end(), longest.begin(), longest.end());
+        }
+
+        for (size_t row : sample) {
+
+            wxString text = derived ? derived->textAt(row) : ListModel::cellText(hostModel->row(row), modelColumn(column));
+            width = std::max(width, extents.width(dc, text));
+        }
+
+        SetColumnWidth(column, std::min(width + Padding, MaxWidth));
+
+        schema.setFitted(column);
+    }
+
+    // Fit the columns in view now; the rest are fitted as they scroll in
+    void autoFitColumns() {
+
+        for (int column = 0; column < GetColumnCount(); column++) {
+            schema.setFitted(column, false);
+        }
+
+        fitVisibleColumns();
+    }
+
+private:
+
+    static constexpr int DefaultWidth = 100;
+
+    // Rows the list shows - group headers included when grouped
+    long listRowCount() const {
+
+        return static_cast<long>(tree ? tree->visibleCount() : hostModel->rowCount());
+    }
+
+    // Model row at a list index (-1 for a group header)
+    long modelRowAt(long index) const {
+
+        if (!tree) {
+            return static_cast<long>(hostModel->modelRow(index));
+        }
+
+        auto node = tree->at(index);
+        return node.isGroup ? -1 : static_cast<long>(node.row);
+    }
+
+    ViewState::Key keyAt(long index) const {
+
+        ViewState::Key key;
+        long row = modelRowAt(index);
+
+        if (row < 0) {
+            key.isGroup = true;
+            key.group = tree->groupLabel(tree->at(index).group);
+        }
+        else {
+            key.id = hostModel->row(static_cast<size_t>(row)).id;
+        }
+
+        return key;
+    }
+
+    void appendColumn(ColumnSchema::Kind kind, uint32_t source, const wxString& title, int width, bool fitted = true) {
+
+        AppendColumn(title, wxLIST_FORMAT_LEFT, width);
+        schema.add(kind, source, title);
+        schema.setFitted(static_cast<int>(schema.size()) - 1, fitted);
+    }
+
+    // Columns that come into view unfitted are fitted once painting is done
+    void fitVisibleColumns() {
+
+        updateVisibleColumns();
+
+        for (int column = visibleFirst; column <= visibleLast; column++) {
+
+            if (!schema.isFitted(column)) {
+                autoFitColumn(column);
+            }
+        }
+
+        fitPending = false;
+    }
+
+#ifdef __WXMSW__
+    // The native list asks for text while it handles WM_PAINT - bracket
+    // that so only paint-time requests skip the off-screen columns
+    WXLRESULT MSWWindowProc(WXUINT message, WXWPARAM wParam, WXLPARAM lParam) override {
+
+        if (message != WM_PAINT) {
+            return wxListCtrl::MSWWindowProc(message, wParam, lParam);
+        }
+
+        beginPaint();
+        WXLRESULT result = wxListCtrl::MSWWindowProc(message, wParam, lParam);
+        painting = false;
+
+        return result;
+    }
+#endif
+
+    // Work out the columns in view for this paint, and size newly revealed
+    // ones to their content afterwards (not mid-paint)
+    void beginPaint() {
+
+        updateVisibleColumns();
+
+#ifdef __WXMSW__
+        painting = true;
+#endif
+
+        for (int column = visibleFirst; column <= visibleLast && !fitPending; column++) {
+
+            if (!schema.isFitted(column)) {
+                fitPending = true;
+                CallAfter([this]() { fitVisibleColumns(); });
+            }
+        }
+    }
+
+    // Binary search the columns for the ones overlapping the client area -
+    // O(log columns) rectangle queries
+    void updateVisibleColumns() {
+
+        int count = GetColumnCount();
+
+        visibleFirst = 0;
+        visibleLast = count - 1;
+
+        if (count <= 1 || GetItemCount() == 0) {
+            return;
+        }
+
+        long item = GetTopItem();
+        int width = GetClientSize().x;
+
+        // left edge in client coordinates (column 0's own rect is the whole row on some ports)
+        auto left = [this, item](int column) {
+
+            wxRect rect;
+            GetSubItemRect(item, std::max(column, 1), rect);
+            return (column == 0) ? rect.x - GetColumnWidth(0) : rect.x;
+            };
+
+        // first column ending right of the left edge
+        int low = 0;
+        int high = count - 1;
+
+        while (low < high) {
+
+            int middle = (low + high) / 2;
+
+            if (left(middle) + GetColumnWidth(middle) > 0) {
+                high = middle;
+            }
+            else {
+                low = middle + 1;
+            }
+        }
+
+        visibleFirst = low;
+
+        // last column starting left of the right edge
+        high = count - 1;
+
+        while (low < high) {
+
+            int middle = (low + high + 1) / 2;
+
+            if (left(middle) < width) {
+                low = middle;
+            }
+            else {
+                high = middle - 1;
+            }
+        }
+
+        visibleLast = low;
+    }
+
+};
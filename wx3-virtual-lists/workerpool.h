@@ -0,0 +1,125 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cstdint>
+
+
+// Threads kept for data-parallel loops (one per core besides the caller),
+// so a filter over a big model doesn't start and join a thread per core
+// every time it runs.  run() hands the same job to the caller and to up to
+// helpers pool threads and returns when all of them have - the job itself
+// shares out the work (e.g. an atomic chunk counter).  Jobs from several
+// threads can run at once: one that finds every pool thread busy with a
+// longer job (a background scan) just runs on its caller.
+class WorkerPool {
+
+public:
+
+    static WorkerPool& shared() {
+
+        static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return pool;
+    }
+
+    explicit WorkerPool(size_t threads) {
+
+        for (size_t t = 0; t < threads; t++) {
+            workers.emplace_back([this]() { work(); });
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool() {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wake.notify_all();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    size_t size() const { return workers.size(); }
+
+    // Run job on this thread and on up to helpers pool threads at once
+    void run(size_t helpers, const std::function<void()>& job) {
+
+        Job item{ &job, std::min(helpers, workers.size()) };
+
+        if (item.wanted > 0) {
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                waiting.push_back(&item);
+            }
+
+            wake.notify_all();
+        }
+
+        job();
+
+        // threads that haven't picked it up yet sit this one out
+        std::unique_lock<std::mutex> lock(mutex);
+
+        waiting.erase(std::remove(waiting.begin(), waiting.end(), &item), waiting.end());
+        done.wait(lock, [&item]() { return item.finished == item.claimed; });
+    }
+
+private:
+
+    struct Job {
+
+        const std::function<void()>* work;
+        size_t  wanted;
+        size_t  claimed{ 0 };
+        size_t  finished{ 0 };
+    };
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    std::deque<Job*> waiting;   // jobs that still want helpers, oldest first
+    bool stopping{ false };
+
+    void work() {
+
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+
+            wake.wait(lock, [this]() { return stopping || !waiting.empty(); });
+
+            if (stopping) {
+                return;
+            }
+
+            Job* job = waiting.front();
+
+            if (++job->claimed == job->wanted) {
+                waiting.pop_front();
+            }
+
+            lock.unlock();
+            (*job->work)();
+            lock.lock();
+
+            job->finished++;
+            done.notify_all();
+        }
+    }
+};